@@ -0,0 +1,22 @@
+#ifndef ASSIGNMENT_H
+#define ASSIGNMENT_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * An alignment of G to H, as found by the solver: node i of G is aligned to node match[i] of H, or to
+ * nothing if match[i] is NONE, with the similarity (1 - cost) of that pair. It takes O(|G|) space,
+ * where the equivalent |G| x |H| matrix is almost entirely zeros.
+ */
+struct Assignment
+{
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    std::size_t rows = 0; // |G|
+    std::size_t cols = 0; // |H|
+    std::vector<std::size_t> match;
+    std::vector<double> similarity;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class Metrics;
+
+/*
+ * A dedicated output thread, so that results are written while later stages compute.
+ * Jobs run one at a time, in the order submitted, from a bounded queue: submitting to a full queue
+ * waits, which caps the memory held by pending output. A job must only read data that stays alive
+ * and unmodified until the writer has been waited on or destroyed. Jobs count their work in the metrics
+ * of the thread that made the writer.
+ */
+class AsyncWriter
+{
+public:
+    explicit AsyncWriter(std::size_t capacity = 4);
+    ~AsyncWriter();
+    AsyncWriter(const AsyncWriter &) = delete;
+    AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+    void submit(std::function<void()> job);
+    void wait();
+
+private:
+    std::size_t capacity_;
+    std::deque<std::function<void()>> jobs_;
+    bool busy_;
+    bool stopping_;
+    std::exception_ptr error_;
+    Metrics *metrics_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::thread thread_;
+
+    void run();
+    void rethrow();
+};
+
+#endif
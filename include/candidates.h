@@ -0,0 +1,20 @@
+#ifndef CANDIDATES_H
+#define CANDIDATES_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * The k least costly nodes of H for each node of G, best first: the r-th candidate of node i of G is
+ * node match[i * k + r] of H, at cost[i * k + r], which is NaN if the pair was pruned. It takes O(|G| k) space, so it can be kept and
+ * written where the |G| x |H| cost matrix it was selected from would not be.
+ */
+struct Candidates
+{
+    std::size_t rows = 0; // |G|
+    std::size_t k = 0;    // at most |H|
+    std::vector<std::size_t> match;
+    std::vector<double> cost;
+};
+
+#endif
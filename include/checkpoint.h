@@ -0,0 +1,29 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <functional>
+#include <string>
+
+/*
+ * The checkpoints of an alignment, kept in a directory of their own so that a run cut short can resume
+ * from its last completed stage. A checkpoint is written under a temporary name, flushed to disk, then
+ * renamed into place, so one that exists is whole. A manifest records the inputs and parameters the
+ * checkpoints were made with, so they are only ever resumed by the same alignment.
+ */
+class Checkpoint
+{
+public:
+    Checkpoint(std::string directory, std::string manifest, unsigned interval_s, bool is_resumed);
+
+    bool has(std::string name) const;
+    std::string path(std::string name) const;
+    void save(std::string name, const std::function<void(std::string)> &write) const;
+    unsigned interval_s() const;
+    void remove() const;
+
+private:
+    std::string directory_;
+    unsigned interval_s_; // the time between snapshots of a long stage, in seconds
+};
+
+#endif
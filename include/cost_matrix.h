@@ -0,0 +1,44 @@
+#ifndef COSTMATRIX_H
+#define COSTMATRIX_H
+
+#include <cstddef>
+#include <string>
+
+/*
+ * A dense, row-major matrix of doubles, held either on the heap or in a memory-mapped scratch file.
+ * Storage is contiguous and aligned to a cache line (or a page, when mapped), so row kernels vectorize.
+ * Stages walk the matrix tile by tile, where a tile is a band of whole rows, and release each tile when
+ * done with it so that a file-backed matrix only keeps the tile in use resident.
+ */
+class CostMatrix
+{
+public:
+    CostMatrix();
+    CostMatrix(std::size_t rows, std::size_t cols, double fill = 0, std::string scratch_dir = "");
+    CostMatrix(CostMatrix &&other) noexcept;
+    CostMatrix &operator=(CostMatrix &&other) noexcept;
+    CostMatrix(const CostMatrix &) = delete;
+    CostMatrix &operator=(const CostMatrix &) = delete;
+    ~CostMatrix();
+
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+    bool is_mapped() const { return mapped_; }
+
+    double *operator[](std::size_t row) { return data_ + row * cols_; }
+    const double *operator[](std::size_t row) const { return data_ + row * cols_; }
+
+    std::size_t tile_rows() const;
+    void release(std::size_t row_begin, std::size_t row_end) const;
+
+private:
+    std::size_t rows_;
+    std::size_t cols_;
+    double *data_;
+    bool mapped_;
+
+    void unmap();
+};
+
+#endif
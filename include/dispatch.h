@@ -0,0 +1,16 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+/*
+ * DISPATCH marks a hot numeric kernel to be compiled once per instruction set (SSE4.2, AVX2, AVX-512)
+ * alongside a portable baseline. The variant to run is picked once at load time from CPUID, so a single
+ * binary built without -march uses the full vector width of whichever machine it runs on.
+ * Function multiversioning needs GCC and an ELF x86-64 target; elsewhere the kernels build normally.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__ELF__)
+#define DISPATCH __attribute__((target_clones("default", "sse4.2", "avx2", "avx512f")))
+#else
+#define DISPATCH
+#endif
+
+#endif
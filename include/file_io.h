@@ -4,23 +4,33 @@
 namespace FileIO
 {
     bool is_accessible(std::string);
+    bool is_directory(std::string);
+    bool is_network_set(std::string);
     bool is_valid_filename(std::string);
+    std::size_t input_size(std::string);
     char detect_delimiter(std::string);
     std::string name_file(std::string, std::string);
     std::string name_directory(std::string, std::string, std::string, std::string, bool, bool, std::string, std::string, bool);
-    void out(std::string, std::string);
-    void err(std::string, std::string);
 
-    std::string graphcrunch_in(std::string, std::string);
+    Graph file_to_graph(std::string, bool);
+    CostMatrix file_to_cost_matrix(std::string, std::string, const std::vector<std::string> &, const std::vector<std::string> &, bool);
+    void scan_cost_matrix(std::string, std::string, const std::vector<std::string> &, const std::vector<std::string> &, bool,
+                          const std::function<void(std::size_t, std::size_t, double *)> &);
+    CostMatrix npy_file_to_matrix(std::string, std::string);
+    std::vector<std::vector<unsigned>> npy_file_to_gdvs(std::string);
 
-    std::vector<std::vector<double>> file_to_matrix(std::string);
-    std::vector<std::string> parse_labels(std::string);
-
-    void graph_to_file(std::string, std::vector<std::string>, std::vector<std::vector<unsigned>>);
+    void graph_to_file(std::string, const Graph &);
+    void graph_to_binary_file(std::string, const Graph &);
     void gdvs_to_file(std::string, std::vector<std::string>, std::vector<std::vector<unsigned>>);
-    void matrix_to_file(std::string, std::vector<std::string>, std::vector<std::string>, std::vector<std::vector<double>>);
-    void alignment_to_matrix_file(std::string, std::vector<std::string>, std::vector<std::string>, std::vector<std::vector<double>>, double);
-    void alignment_to_list_file(std::string, std::vector<std::string>, std::vector<std::string>, std::vector<std::vector<double>>, double);
+    void matrix_to_file(std::string, std::vector<std::string>, std::vector<std::string>, const CostMatrix &);
+    void labels_to_file(std::string, const std::vector<std::string> &);
+    void matrix_to_npy_file(std::string, const CostMatrix &);
+    void gdvs_to_npy_file(std::string, const std::vector<std::vector<unsigned>> &);
+    void alignment_to_matrix_file(std::string, std::vector<std::string>, std::vector<std::string>, const Assignment &, double);
+    void alignment_to_list_file(std::string, std::vector<std::string>, std::vector<std::string>, const Assignment &, double);
+    void candidates_to_file(std::string, const std::vector<std::string> &, const std::vector<std::string> &, const Candidates &);
+    void summary_to_file(std::string, std::string, const std::vector<std::string> &, const std::vector<double> &);
+    void metrics_to_file(std::string, const Metrics &);
 }
 
 #endif
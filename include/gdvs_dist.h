@@ -3,7 +3,8 @@
 
 namespace GDVs_Dist
 {
-    std::vector<std::vector<double>> gdvs_dist(std::vector<std::vector<unsigned>>, std::vector<std::vector<unsigned>>, double);
+    CostMatrix gdvs_dist(const std::vector<std::vector<unsigned>> &, const std::vector<std::vector<unsigned>> &, double, double, std::string);
+    CostMatrix degree_dist(const std::vector<unsigned> &, const std::vector<unsigned> &, std::string);
 }
 
 #endif
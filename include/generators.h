@@ -0,0 +1,12 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+namespace Generators
+{
+    Graph erdos_renyi(std::size_t, double, std::uint64_t);
+    Graph barabasi_albert(std::size_t, std::size_t, std::uint64_t);
+    Graph blocks(std::size_t, std::size_t, double, double, std::uint64_t);
+    CostMatrix uniform_costs(std::size_t, std::size_t, std::uint64_t);
+}
+
+#endif
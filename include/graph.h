@@ -0,0 +1,24 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * A labelled network in compressed sparse row form.
+ * The neighbors of node i are neighbors[offsets[i]] .. neighbors[offsets[i + 1] - 1], in increasing order,
+ * and are exactly the nonzero entries of row i of the input adjacency matrix. If the input's edge weights
+ * were kept, weights runs parallel to neighbors; otherwise it is empty.
+ */
+struct Graph
+{
+    std::vector<std::string> labels;
+    std::vector<std::size_t> offsets;
+    std::vector<unsigned> neighbors;
+    std::vector<double> weights;
+
+    std::size_t size() const { return labels.size(); }
+};
+
+#endif
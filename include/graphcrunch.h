@@ -4,6 +4,7 @@
 namespace GraphCrunch
 {
     std::vector<std::vector<unsigned>> graphcrunch(std::string);
+    std::vector<std::vector<unsigned>> graphcrunch(const Graph &);
 }
 
 #endif
@@ -3,7 +3,7 @@
 
 namespace Hungarian
 {
-    std::vector<std::vector<double>> hungarian(std::vector<std::vector<double>>);
+    Assignment hungarian(const CostMatrix &, std::string, bool, const Checkpoint * = nullptr);
 }
 
 #endif
@@ -0,0 +1,85 @@
+#ifndef LIBMINAA_H
+#define LIBMINAA_H
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "assignment.h"
+#include "cost_matrix.h"
+#include "graph.h"
+
+/*
+ * The alignment of networks held in memory, for programs that embed MiNAA rather than run it on files.
+ * Nothing is read from or written to the filesystem, and nothing is printed: inputs are viewed in the
+ * caller's memory, and results are returned.
+ */
+namespace MiNAA
+{
+    /*
+     * A network, viewed in compressed sparse row form: the neighbors of node i are
+     * neighbors[offsets[i]] .. neighbors[offsets[i + 1] - 1]. As with an input file, the edges are the
+     * entries in the upper triangle of the adjacency matrix, so an undirected network may list each
+     * edge in both directions or only once, and self-loops are ignored. Nodes are identified by their index.
+     */
+    struct GraphView
+    {
+        std::size_t size = 0;                 // the number of nodes
+        const std::size_t *offsets = nullptr; // size + 1 entries
+        const unsigned *neighbors = nullptr;  // offsets[size] entries
+    };
+
+    /*
+     * A biological matrix, viewed as |G| x |H| values in row-major order, with rows indexed by the nodes
+     * of G and columns by the nodes of H. Values are normalized before use, as with an input file.
+     */
+    struct CostView
+    {
+        std::size_t rows = 0;
+        std::size_t cols = 0;
+        const double *values = nullptr;
+        bool is_similarity = false; // convert similarities to costs, as with the -s option?
+    };
+
+    /*
+     * How to align a pair of networks, as with the command line options of the same names.
+     */
+    struct Options
+    {
+        double alpha = 1;                // GDV - edge weight balancer
+        double beta = 1;                 // topological - biological balancer
+        double similarity_threshold = 0; // pairs provably less similar than this are pruned, if do_prune
+        bool do_prune = false;           // prune pairs, at cost NaN? The alignment may then differ
+        bool do_gdvs = false;            // return the GDVs of G and H?
+    };
+
+    /*
+     * The alignment of G to H, the cost matrix it was found by, and, if asked for and counted, the GDVs
+     * of G and H. The cost of a pruned pair is NaN, and it is aligned as if at the maximal cost.
+     */
+    struct Result
+    {
+        Assignment alignment;
+        CostMatrix costs;
+        std::vector<std::vector<unsigned>> g_gdvs;
+        std::vector<std::vector<unsigned>> h_gdvs;
+    };
+
+    /*
+     * The stages of an alignment that its options make relevant. The command line program plans its
+     * stages, and calculates its topological costs, with these functions too.
+     */
+    struct Stages
+    {
+        bool do_topology = true;  // with beta = 0 the topological costs carry no weight
+        bool do_graphlets = true; // with alpha = 0 the topological costs only use node degrees
+        double cutoff = 1;        // pairs whose topological cost provably exceeds it are pruned, unless it is 1
+    };
+
+    Stages stages(Options, bool);
+    CostMatrix topological_costs(const Stages &, double, const Graph &, const Graph &,
+                                 const std::vector<std::vector<unsigned>> &, const std::vector<std::vector<unsigned>> &, std::string);
+    Result align(GraphView, GraphView, std::optional<CostView>, Options);
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <fstream>
+#include <string>
+
+/*
+ * The run log, echoed to the console. The log file is held open for the whole run and written a line
+ * at a time, i.e. once per stage, rather than reopened for every message. Messages logged before the
+ * file is opened are kept and written when it is.
+ */
+class Logger
+{
+public:
+    enum Level
+    {
+        DEBUG,
+        INFO,
+        ERROR
+    };
+
+    Logger();
+    ~Logger();
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    void open(std::string filepath);
+    void set_level(Level level) { level_ = level; }
+    void set_quiet(bool quiet) { quiet_ = quiet; }
+    bool is_quiet() const { return quiet_; }
+
+    void out(std::string str, Level level = INFO);
+    void err(std::string str);
+    void flush();
+
+private:
+    std::ofstream file_;
+    std::string buffer_;
+    Level level_;
+    bool quiet_;
+};
+
+#endif
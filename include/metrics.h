@@ -0,0 +1,92 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Performance measurements of one alignment: how long each stage took, and the process's peak resident
+ * memory by its end, with counters of the work done. Stages are timed by scoped timers. Counters are
+ * added to from wherever the work is done, on whichever thread, through the metrics that are current
+ * on that thread; the threads that run an alignment's stages take on the metrics of the thread that
+ * started them, and work done with no current metrics is not counted.
+ */
+class Metrics
+{
+public:
+    enum Counter
+    {
+        GRAPHLETS,     // graphlets enumerated while counting GDVs
+        COST_PAIRS,    // pairs of nodes whose topological cost was calculated in full
+        PRUNED_PAIRS,  // pairs of nodes whose topological cost was abandoned by pruning
+        AUGMENTATIONS, // augmenting paths followed by the solver
+        BYTES_READ,    // bytes of input read, after decompression
+        BYTES_WRITTEN, // bytes of output written, after compression
+        COUNTERS
+    };
+
+    /*
+     * Makes the given metrics current on this thread for its lifetime.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(Metrics *metrics);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Metrics *previous_;
+    };
+
+    /*
+     * Times a stage, from construction until stopped or destroyed.
+     */
+    class Timer
+    {
+    public:
+        Timer(Metrics &metrics, std::string stage);
+        ~Timer();
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+        long long stop();
+
+    private:
+        Metrics &metrics_;
+        std::string stage_;
+        std::chrono::steady_clock::time_point start_;
+        bool is_stopped_;
+    };
+
+    Metrics();
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    static Metrics *current();
+    static void add(Counter counter, unsigned long long n);
+
+    void record(std::string stage, long long ms);
+    long long elapsed_ms() const;
+    std::string to_json() const;
+
+private:
+    struct Stage
+    {
+        std::string name;
+        long long ms;
+        std::size_t process_peak_rss; // of the whole process by the end of the stage, in bytes
+    };
+
+    std::chrono::steady_clock::time_point start_;
+    std::atomic<unsigned long long> counters_[COUNTERS];
+    mutable std::mutex mutex_;
+    std::vector<Stage> stages_;
+};
+
+#endif
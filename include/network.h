@@ -0,0 +1,25 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <string>
+#include <vector>
+
+#include "graph.h"
+
+/*
+ * A network to align, with what is derived from it kept for every alignment it takes part in.
+ * The graph is read, and its GDVs counted, the first time an alignment needs them.
+ */
+struct Network
+{
+    std::string file; // the file the graph is read from
+    std::string name; // the name of the network in output file and directory names
+
+    Graph graph;
+    bool is_loaded = false;
+
+    std::vector<std::vector<unsigned>> gdvs;
+    bool is_counted = false;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef NETWORKCACHE_H
+#define NETWORKCACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "network.h"
+
+/*
+ * The networks most recently aligned by a long-running process, read and with their GDVs counted, so
+ * that a network aligned again is not processed again. A network is identified by its file, and read
+ * again if the file has changed since. Once more than the capacity is cached, the least recently used
+ * network is dropped. Networks are shared, so alignments on any thread may use the cache at once, and
+ * a network requested by several of them at once is only processed by one.
+ */
+class NetworkCache
+{
+public:
+    explicit NetworkCache(std::size_t capacity);
+    NetworkCache(const NetworkCache &) = delete;
+    NetworkCache &operator=(const NetworkCache &) = delete;
+
+    Network get(std::string filepath, std::string alias, bool do_count);
+
+private:
+    struct Entry
+    {
+        std::mutex mutex; // held while the network is read or counted
+        Network network;
+    };
+
+    std::size_t capacity_;
+    std::list<std::string> order_; // cached keys, most recently used first
+    std::unordered_map<std::string, std::pair<std::shared_ptr<Entry>, std::list<std::string>::iterator>> entries_;
+    std::mutex mutex_;
+
+    std::shared_ptr<Entry> entry(std::string key, std::string filepath);
+};
+
+#endif
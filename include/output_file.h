@@ -0,0 +1,31 @@
+#ifndef OUTPUTFILE_H
+#define OUTPUTFILE_H
+
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+/*
+ * A text output file. If its path ends in .gz it is gzip-compressed as it is written, a chunk at a time,
+ * so the compressed file never has to be held in memory.
+ */
+class OutputFile : public std::ostream
+{
+public:
+    explicit OutputFile(std::string filepath);
+    ~OutputFile();
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    void close();
+
+private:
+    class GzipBuffer;
+
+    std::string filepath_;
+    std::filebuf file_;
+    std::unique_ptr<GzipBuffer> gzip_;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+namespace Pipeline
+{
+    Settings settings(const std::vector<std::string> &, std::string);
+    Network network(std::string, std::string);
+    void load(Network &);
+    void count(Network &);
+    std::vector<std::string> network_files(std::string);
+    std::pair<std::string, std::size_t> plan(const Settings &, const Network &, const Network &, bool);
+    Assignment align(const Settings &, Network &, Network &, Logger &);
+    std::size_t align_all(const Settings &, std::vector<Network> &, std::vector<Network> &, bool);
+    std::size_t sweep(const Settings &, Network &, Network &, const std::vector<std::string> &, const std::vector<std::string> &);
+}
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+namespace Server
+{
+    void serve(std::string, std::size_t);
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <cstddef>
+#include <string>
+
+/*
+ * How to align a pair of networks, as given on the command line. The same settings apply to every
+ * pair when one network is aligned to many.
+ */
+struct Settings
+{
+    std::string command;                  // the command line, as logged
+    std::string datetime;                 // the time of execution, for timestamps
+    std::string base_path = "alignments"; // the directory in which output directories are made
+
+    std::string bio_file;  // biological data file, or empty for none
+    std::string bio_alias; // biological data alias
+    std::string g_alias;   // graph G alias
+    std::string h_alias;   // graph H alias
+
+    double alpha = 1;                // GDV - edge weight balancer
+    double beta = 1;                 // topological - biological balancer
+    double similarity_threshold = 0; // similarity threshold above which alignments report
+    bool do_prune = false;           // prune the topological costs of pairs below the threshold?
+    std::string alpha_stamp = "1";   // alpha, as written in a greekstamp
+    std::string beta_stamp = "1";    // beta, as written in a greekstamp
+
+    bool do_passthrough = false;           // do a passthrough of input files?
+    bool do_timestamp = false;             // include a timestamp in the directory name?
+    bool do_greekstamp = false;            // include a greekstamp in the directory name?
+    bool do_similarity_conversion = false; // convert biological similarity to costs?
+    std::string scratch_dir;               // directory for out-of-core cost matrices
+    bool do_binary_graphs = false;         // write the graphs as binary CSR files?
+    bool do_npy = false;                   // write cost matrices and GDVs as .npy files?
+    bool is_quiet = false;                 // print only errors to the console?
+    bool is_verbose = false;               // also log debugging details?
+    bool do_compress = false;              // gzip-compress the CSV outputs?
+    std::size_t top_k = 0;                 // number of candidates to list per node of G
+    std::size_t mem_limit = 0;             // the most memory an alignment may take, in bytes, or 0 for no limit
+    unsigned checkpoint_s = 0;             // seconds between snapshots of the solver, or 0 for no checkpoints
+    bool do_resume = false;                // resume from the checkpoints in the output directory?
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/*
+ * A small graph of tasks, each run once all the tasks it comes after have finished. Independent tasks
+ * run at the same time, on a pool of threads, so the whole graph takes about as long as its longest
+ * chain of tasks. The time each task ran is recorded, so stages can still be timed and logged in order.
+ * Tasks count their work in the metrics of the thread that runs the graph, and keep to its thread budget.
+ */
+class TaskGraph
+{
+public:
+    typedef std::size_t Task;
+
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+    Task add(std::function<void()> fn, std::vector<Task> after = {});
+    void run(std::size_t threads);
+    long long elapsed_ms(std::vector<Task> tasks) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Node
+    {
+        std::function<void()> fn;
+        std::vector<Task> next; // the tasks that come after this one
+        std::size_t waiting;    // the number of tasks this one still comes after
+        Clock::time_point start;
+        Clock::time_point finish;
+        bool ran = false;
+    };
+
+    std::vector<Node> nodes_;
+};
+
+#endif
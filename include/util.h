@@ -5,11 +5,21 @@ namespace Util
 {
     std::string now();
     std::string to_string(double, int);
+    std::vector<std::string> split(std::string, char);
     std::vector<std::string> parse_args(int, char **);
-    std::vector<std::vector<unsigned>> binarify(std::vector<std::vector<double>>);
-    std::vector<std::vector<double>> normalize(std::vector<std::vector<double>>);
-    std::vector<std::vector<double>> one_minus(std::vector<std::vector<double>>);
-    std::vector<std::vector<double>> combine(std::vector<std::vector<double>>, std::vector<std::vector<double>>, double);
+    std::vector<std::string> parse_serve_args(int, char **);
+    std::vector<unsigned> degrees(const Graph &);
+    std::size_t physical_memory();
+    double net_cost(const Assignment &, double);
+    std::size_t thread_budget();
+    void set_thread_budget(std::size_t);
+    void parallel_for(std::size_t, std::size_t, const std::function<void(std::size_t, std::size_t)> &);
+    void normalize(CostMatrix &, bool);
+    void one_minus(CostMatrix &);
+    void combine(const CostMatrix &, CostMatrix &, double, bool, bool);
+    CostMatrix blend(const CostMatrix &, const CostMatrix &, double, std::string);
+    Candidates top_k(const CostMatrix &, std::size_t);
+    void combine_streamed(CostMatrix &, std::string, std::string, const std::vector<std::string> &, const std::vector<std::string> &, double, bool);
 }
 
 #endif
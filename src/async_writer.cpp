@@ -0,0 +1,122 @@
+// async_writer.cpp
+// Background Output Writer
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "async_writer.h"
+#include "metrics.h"
+
+/**
+ * Start the writer thread.
+ *
+ * @param capacity The most jobs that may wait in the queue at once.
+ */
+AsyncWriter::AsyncWriter(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(1, capacity)), busy_(false), stopping_(false), error_(nullptr), metrics_(Metrics::current())
+{
+    thread_ = std::thread(&AsyncWriter::run, this);
+}
+
+/*
+ * Finish every queued job, then stop the writer thread. Errors not yet collected by wait are dropped.
+ */
+AsyncWriter::~AsyncWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+}
+
+/**
+ * Queue a job for the writer thread, waiting for room if the queue is full.
+ *
+ * @param job The job to run.
+ *
+ * @throws The error of an earlier job, if one failed; the new job is then not queued.
+ */
+void AsyncWriter::submit(std::function<void()> job)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this]() { return jobs_.size() < capacity_ || error_; });
+    rethrow();
+    jobs_.push_back(std::move(job));
+    lock.unlock();
+    changed_.notify_all();
+}
+
+/**
+ * Wait until every queued job has finished.
+ *
+ * @throws The error of the first job that failed. No jobs run after a failure.
+ */
+void AsyncWriter::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this]() { return (jobs_.empty() && !busy_) || error_; });
+    rethrow();
+}
+
+void AsyncWriter::run()
+{
+    Metrics::Scope scope(metrics_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        changed_.wait(lock, [this]() { return !jobs_.empty() || stopping_; });
+        if (jobs_.empty() || error_)
+        {
+            if (stopping_)
+            {
+                return;
+            }
+            jobs_.clear(); // a failed writer runs nothing more
+            continue;
+        }
+
+        auto job = std::move(jobs_.front());
+        jobs_.pop_front();
+        busy_ = true;
+        lock.unlock();
+        changed_.notify_all();
+
+        std::exception_ptr error = nullptr;
+        try
+        {
+            job();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        busy_ = false;
+        if (error && !error_)
+        {
+            error_ = error;
+        }
+        changed_.notify_all();
+    }
+}
+
+/*
+ * Rethrow the first job error, if any. The mutex must be held.
+ */
+void AsyncWriter::rethrow()
+{
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
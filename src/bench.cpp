@@ -0,0 +1,240 @@
+// bench.cpp
+// Stage Benchmarks on Synthetic Networks
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "assignment.h"
+#include "candidates.h"
+#include "checkpoint.h"
+#include "cost_matrix.h"
+#include "graph.h"
+#include "metrics.h"
+#include "generators.h"
+#include "gdvs_dist.h"
+#include "graphcrunch.h"
+#include "hungarian.h"
+#include "file_io.h"
+#include "util.h"
+
+/*
+ * How to benchmark, as given on the command line.
+ */
+struct Options
+{
+    std::vector<std::size_t> sizes = {250}; // the numbers of nodes of the networks
+    double density = 0.05;                  // the expected density of the networks
+    std::uint64_t seed = 1;                 // the seed of G; H is seeded with the next one
+    unsigned reps = 3;                      // the runs of each stage, of which the median is reported
+    std::string baseline;                   // a file of earlier results to compare to, or empty for none
+    std::string output;                     // the file to write the results to, or empty for the console
+};
+
+/*
+ * Parse the command line arguments.
+ */
+Options parse_args(int argc, char *argv[])
+{
+    Options options;
+    for (auto i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.find("-n=") == 0)
+        {
+            options.sizes.clear();
+            for (const auto &size : Util::split(arg.substr(3), ','))
+            {
+                options.sizes.push_back(std::stoul(size));
+                if (options.sizes.back() < 2)
+                {
+                    throw std::invalid_argument("The networks must have at least 2 nodes.");
+                }
+            }
+        }
+        else if (arg.find("-d=") == 0)
+        {
+            options.density = std::stod(arg.substr(3));
+            if (options.density <= 0 || options.density > 0.4)
+            {
+                throw std::invalid_argument("The density must be in range (0, 0.4].");
+            }
+        }
+        else if (arg.find("-seed=") == 0)
+        {
+            options.seed = std::stoull(arg.substr(6));
+        }
+        else if (arg.find("-reps=") == 0)
+        {
+            options.reps = std::stoul(arg.substr(6));
+            if (options.reps < 1)
+            {
+                throw std::invalid_argument("There must be at least one rep.");
+            }
+        }
+        else if (arg.find("-baseline=") == 0)
+        {
+            options.baseline = arg.substr(10);
+            if (!FileIO::is_accessible(options.baseline))
+            {
+                throw std::invalid_argument("The baseline file cannot be read.");
+            }
+        }
+        else if (arg.find("-o=") == 0)
+        {
+            options.output = arg.substr(3);
+        }
+        else
+        {
+            throw std::invalid_argument("Invalid argument: " + arg +
+                                        "\nUsage: ./bench.exe [-n=sizes] [-d=density] [-seed=s] [-reps=r] [-baseline=file] [-o=file]");
+        }
+    }
+    return options;
+}
+
+/*
+ * The median time of a stage, in milliseconds, over the given number of runs. Each run first prepares
+ * its inputs, untimed, then runs the stage.
+ */
+double median_ms(unsigned reps, const std::function<void()> &prepare, const std::function<void()> &stage)
+{
+    std::vector<double> times;
+    for (unsigned r = 0; r < reps; ++r)
+    {
+        prepare();
+        auto s = std::chrono::steady_clock::now();
+        stage();
+        auto f = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(f - s).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+/*
+ * The times of an earlier run, by the generator, size and stage they are of.
+ */
+std::map<std::string, double> read_baseline(std::string filepath)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream fin(filepath);
+    std::string line;
+    std::getline(fin, line); // header
+    while (std::getline(fin, line))
+    {
+        auto cells = Util::split(line, ',');
+        if (cells.size() >= 5)
+        {
+            baseline[cells[0] + ',' + cells[1] + ',' + cells[3]] = std::stod(cells[4]);
+        }
+    }
+    return baseline;
+}
+
+/*
+ * Benchmark each stage of an alignment in isolation, on pairs of seeded synthetic networks of each
+ * generator and size, and report the median time of each as CSV, compared to a baseline if one is given.
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    std::map<std::string, double> baseline;
+    try
+    {
+        options = parse_args(argc, argv);
+        if (options.baseline != "")
+        {
+            baseline = read_baseline(options.baseline);
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "ERROR: " << e.what() << "\nPROGRAM TERMINATING" << std::endl;
+        return 1;
+    }
+
+    std::ofstream file;
+    if (options.output != "")
+    {
+        file.open(options.output);
+    }
+    std::ostream &out = (options.output != "") ? file : std::cout;
+    out << "generator,nodes,edges,stage,ms" << (baseline.empty() ? "" : ",baseline_ms,ratio") << std::endl;
+
+    auto csv_file = (std::filesystem::temp_directory_path() / "minaa_bench.csv").string();
+    try
+    {
+        for (auto n : options.sizes)
+        {
+            // Generators of about the same density: a BA network has about m n edges, and the blocks are
+            // five times as dense inside as between
+            auto d = options.density;
+            std::vector<std::pair<std::string, std::function<Graph(std::uint64_t)>>> generators = {
+                {"erdos_renyi", [&](std::uint64_t seed) { return Generators::erdos_renyi(n, d, seed); }},
+                {"barabasi_albert", [&](std::uint64_t seed) { return Generators::barabasi_albert(n, std::clamp<std::size_t>(std::lround(d * (n - 1) / 2), 1, n - 1), seed); }},
+                {"blocks", [&](std::uint64_t seed) { return Generators::blocks(n, 4, std::min(1.0, 2.5 * d), d / 2, seed); }}};
+
+            for (auto &[name, generate] : generators)
+            {
+                auto g = generate(options.seed);
+                auto h = generate(options.seed + 1);
+                std::vector<std::pair<std::string, double>> times;
+
+                FileIO::graph_to_file(csv_file, g);
+                times.push_back({"parse_csv", median_ms(options.reps, []() {}, [&]() { FileIO::file_to_graph(csv_file, false); })});
+
+                std::vector<std::vector<unsigned>> g_gdvs;
+                auto h_gdvs = GraphCrunch::graphcrunch(h);
+                times.push_back({"graphcrunch", median_ms(options.reps, []() {}, [&]() { g_gdvs = GraphCrunch::graphcrunch(g); })});
+
+                CostMatrix top;
+                times.push_back({"gdvs_dist", median_ms(options.reps, []() {}, [&]() { top = GDVs_Dist::gdvs_dist(g_gdvs, h_gdvs, 1, 1, ""); })});
+
+                CostMatrix overall;
+                times.push_back({"combine", median_ms(options.reps, [&]() { overall = Generators::uniform_costs(g.size(), h.size(), options.seed); },
+                                                      [&]() { Util::combine(top, overall, 0.5, true, false); })});
+
+                times.push_back({"hungarian", median_ms(options.reps, []() {}, [&]() { Hungarian::hungarian(overall, "", false); })});
+
+                for (auto &[stage, ms] : times)
+                {
+                    out << name << ',' << n << ',' << g.neighbors.size() / 2 << ',' << stage << ',' << ms;
+                    if (!baseline.empty())
+                    {
+                        auto found = baseline.find(name + ',' + std::to_string(n) + ',' + stage);
+                        if (found != baseline.end() && found->second > 0)
+                        {
+                            out << ',' << found->second << ',' << ms / found->second;
+                        }
+                        else
+                        {
+                            out << ",NA,NA";
+                        }
+                    }
+                    out << std::endl;
+                }
+            }
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::filesystem::remove(csv_file);
+        std::cerr << "ERROR: " << e.what() << "\nPROGRAM TERMINATING" << std::endl;
+        return 1;
+    }
+    std::filesystem::remove(csv_file);
+
+    return 0;
+}
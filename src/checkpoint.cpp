@@ -0,0 +1,154 @@
+// checkpoint.cpp
+// Durable Checkpoints of an Alignment
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "checkpoint.h"
+
+namespace
+{
+    const std::string MANIFEST_FILENAME = "manifest.txt";
+
+    /*
+     * Flush a file or directory to disk, so that it survives the machine going down, where the platform allows it.
+     */
+    void sync(std::string path)
+    {
+        #ifndef _WIN32 // Unix
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd != -1)
+        {
+            fsync(fd);
+            close(fd);
+        }
+        #else
+        (void)path;
+        #endif
+    }
+}
+
+/**
+ * Open the checkpoints in the given directory. Unless resuming, any checkpoints already there are
+ * removed, so the alignment starts over.
+ *
+ * @param directory The directory the checkpoints are kept in, ending in a path separator.
+ * @param manifest The inputs and parameters of the alignment, as text.
+ * @param interval_s The time between snapshots of a long stage, in seconds.
+ * @param is_resumed Whether to resume from the checkpoints already in the directory, if there are any.
+ *
+ * @throws std::runtime_error If the checkpoints being resumed are of a different alignment, or the
+ *                            directory could not be made.
+ */
+Checkpoint::Checkpoint(std::string directory, std::string manifest, unsigned interval_s, bool is_resumed)
+    : directory_(std::move(directory)), interval_s_(interval_s)
+{
+    if (is_resumed && has(MANIFEST_FILENAME))
+    {
+        std::ifstream fin(path(MANIFEST_FILENAME));
+        std::stringstream saved;
+        saved << fin.rdbuf();
+        if (saved.str() != manifest)
+        {
+            throw std::runtime_error("The checkpoints in " + directory_ + " are of a different alignment. Remove them, or run without -resume, to start over.");
+        }
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(directory_, error);
+    std::filesystem::create_directories(directory_, error);
+    if (error)
+    {
+        throw std::runtime_error("Unable to make the checkpoint directory " + directory_);
+    }
+    save(MANIFEST_FILENAME, [&](std::string filepath)
+    {
+        std::ofstream fout(filepath);
+        fout << manifest;
+        if (!fout.good())
+        {
+            throw std::runtime_error("Unable to write to file " + filepath);
+        }
+    });
+}
+
+/**
+ * Whether the given checkpoint was saved.
+ *
+ * @param name The name of the checkpoint.
+ *
+ * @return True if the checkpoint exists, whole.
+ */
+bool Checkpoint::has(std::string name) const
+{
+    std::error_code error;
+    return std::filesystem::is_regular_file(path(name), error);
+}
+
+/**
+ * The file of the given checkpoint.
+ *
+ * @param name The name of the checkpoint.
+ *
+ * @return The path to the file.
+ */
+std::string Checkpoint::path(std::string name) const
+{
+    return directory_ + name;
+}
+
+/**
+ * Save a checkpoint, replacing any saved before under the same name only once the new one is whole
+ * and on disk.
+ *
+ * @param name The name of the checkpoint.
+ * @param write Writes the checkpoint to the file at the path it is given.
+ *
+ * @throws std::runtime_error If the checkpoint could not be written.
+ */
+void Checkpoint::save(std::string name, const std::function<void(std::string)> &write) const
+{
+    auto partial = path(name) + ".partial";
+    write(partial);
+    sync(partial);
+
+    std::error_code error;
+    std::filesystem::rename(partial, path(name), error);
+    if (error)
+    {
+        std::filesystem::remove(partial, error);
+        throw std::runtime_error("Unable to save checkpoint " + path(name));
+    }
+    sync(directory_);
+}
+
+/**
+ * The time between snapshots of a long stage.
+ *
+ * @return The time in seconds.
+ */
+unsigned Checkpoint::interval_s() const
+{
+    return interval_s_;
+}
+
+/**
+ * Remove every checkpoint, once the alignment is complete.
+ */
+void Checkpoint::remove() const
+{
+    std::error_code error;
+    std::filesystem::remove_all(directory_, error);
+}
@@ -0,0 +1,194 @@
+// cost_matrix.cpp
+// In-Memory and Out-of-Core Cost Matrix Storage
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "cost_matrix.h"
+
+namespace
+{
+    const std::size_t TILE_BYTES = 64 << 20; // target size of one band of rows
+    const std::align_val_t ALIGNMENT{64};    // a cache line, and the width of an AVX-512 register
+}
+
+CostMatrix::CostMatrix() : rows_(0), cols_(0), data_(nullptr), mapped_(false)
+{
+}
+
+/**
+ * Allocate a rows x cols matrix with every entry set to fill.
+ *
+ * @param rows The number of rows.
+ * @param cols The number of columns.
+ * @param fill The initial value of every entry.
+ * @param scratch_dir If nonempty, the directory in which to back the matrix by a memory-mapped file.
+ *
+ * @throws std::runtime_error If the scratch file could not be created or mapped.
+ */
+CostMatrix::CostMatrix(std::size_t rows, std::size_t cols, double fill, std::string scratch_dir)
+    : rows_(rows), cols_(cols), data_(nullptr), mapped_(false)
+{
+    if (empty())
+    {
+        return;
+    }
+
+    #ifndef _WIN32 // Unix
+    if (scratch_dir != "")
+    {
+        // Create an anonymous scratch file, which disappears once it is unmapped
+        auto path = scratch_dir + "/minaa_costs_XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        int fd = mkstemp(name.data());
+        if (fd == -1)
+        {
+            throw std::runtime_error("Unable to create scratch file in " + scratch_dir);
+        }
+        unlink(name.data());
+
+        auto bytes = rows_ * cols_ * sizeof(double);
+        if (ftruncate(fd, bytes) == -1)
+        {
+            close(fd);
+            throw std::runtime_error("Unable to allocate " + std::to_string(bytes) + " bytes in " + scratch_dir);
+        }
+
+        void *addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            throw std::runtime_error("Unable to map scratch file in " + scratch_dir + ": " + std::strerror(errno));
+        }
+
+        data_ = static_cast<double *>(addr);
+        mapped_ = true;
+
+        // Fill tile by tile, so the whole matrix is never resident at once
+        for (std::size_t r = 0; r < rows_; r += tile_rows())
+        {
+            auto end = std::min(rows_, r + tile_rows());
+            if (fill != 0) // a fresh file already reads as zeros
+            {
+                std::fill((*this)[r], (*this)[r] + (end - r) * cols_, fill);
+            }
+            release(r, end);
+        }
+        return;
+    }
+    #else
+    (void)scratch_dir;
+    #endif
+
+    data_ = static_cast<double *>(::operator new[](rows_ * cols_ * sizeof(double), ALIGNMENT));
+    std::fill(data_, data_ + rows_ * cols_, fill);
+}
+
+CostMatrix::CostMatrix(CostMatrix &&other) noexcept
+    : rows_(other.rows_), cols_(other.cols_), data_(other.data_), mapped_(other.mapped_)
+{
+    other.rows_ = 0;
+    other.cols_ = 0;
+    other.data_ = nullptr;
+    other.mapped_ = false;
+}
+
+CostMatrix &CostMatrix::operator=(CostMatrix &&other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        rows_ = other.rows_;
+        cols_ = other.cols_;
+        data_ = other.data_;
+        mapped_ = other.mapped_;
+        other.rows_ = 0;
+        other.cols_ = 0;
+        other.data_ = nullptr;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+CostMatrix::~CostMatrix()
+{
+    unmap();
+}
+
+/**
+ * The number of rows in one tile, such that a tile is about TILE_BYTES.
+ *
+ * @return The number of rows per tile, at least 1.
+ */
+std::size_t CostMatrix::tile_rows() const
+{
+    if (cols_ == 0)
+    {
+        return 1;
+    }
+    return std::max<std::size_t>(1, TILE_BYTES / (cols_ * sizeof(double)));
+}
+
+/**
+ * Signal that the rows in [row_begin, row_end) are not needed for now.
+ * A file-backed matrix schedules them to be written back and drops them from memory; they are
+ * transparently paged back in if accessed again. Does nothing for a heap-backed matrix.
+ *
+ * @param row_begin The first row of the released band.
+ * @param row_end One past the last row of the released band.
+ */
+void CostMatrix::release(std::size_t row_begin, std::size_t row_end) const
+{
+    #ifndef _WIN32 // Unix
+    if (!mapped_ || row_begin >= row_end)
+    {
+        return;
+    }
+
+    // madvise and msync work on whole pages, so only release the pages entirely inside the band
+    const std::size_t page = sysconf(_SC_PAGESIZE);
+    auto begin = reinterpret_cast<std::uintptr_t>(data_ + row_begin * cols_);
+    auto end = reinterpret_cast<std::uintptr_t>(data_ + row_end * cols_);
+    begin = (begin + page - 1) / page * page;
+    end = end / page * page;
+    if (begin < end)
+    {
+        msync(reinterpret_cast<void *>(begin), end - begin, MS_ASYNC);
+        madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+    }
+    #else
+    (void)row_begin;
+    (void)row_end;
+    #endif
+}
+
+void CostMatrix::unmap()
+{
+    #ifndef _WIN32 // Unix
+    if (mapped_ && data_ != nullptr)
+    {
+        munmap(data_, rows_ * cols_ * sizeof(double));
+        data_ = nullptr;
+    }
+    #endif
+    if (data_ != nullptr)
+    {
+        ::operator delete[](data_, ALIGNMENT);
+    }
+    data_ = nullptr;
+    mapped_ = false;
+}
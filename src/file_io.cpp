@@ -4,11 +4,40 @@
 
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
-#include <sstream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <sys/stat.h>
+#include <zlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "assignment.h"
+#include "candidates.h"
+#include "cost_matrix.h"
+#include "graph.h"
+#include "metrics.h"
+#include "output_file.h"
+#include "util.h"
 
 namespace FileIO
 {
@@ -25,6 +54,32 @@ namespace FileIO
         return fin.good();
     }
 
+    /**
+     * Returns whether or not the given string is a path to an existing directory.
+     *
+     * @param path The path to check.
+     *
+     * @return True if the path is a directory, false otherwise.
+     */
+    bool is_directory(std::string path)
+    {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+    }
+
+    /**
+     * Returns whether or not the given path names a set of networks rather than one: a directory of
+     * network files, or a list file ending in .list with one network file per line.
+     *
+     * @param path The path to check.
+     *
+     * @return True if the path names a set of networks, false otherwise.
+     */
+    bool is_network_set(std::string path)
+    {
+        return is_directory(path) || (path.size() > 5 && path.compare(path.size() - 5, 5, ".list") == 0);
+    }
+
     /**
      * Check if the given string is a valid file name.
      *
@@ -38,37 +93,20 @@ namespace FileIO
     }
 
     /**
-     * Detect the delimiter used for a CSV file.
+     * Detect the delimiter used in a CSV file, from its first line.
      * Detectable delimiters are comma, semicolon, space, and tab.
      *
-     * @param filepath Path to the csv file to detect the delimiter of.
+     * @param line The first line of the csv file.
      *
      * @return the delimiter used in the file.
-     *
-     * @throws std::runtime_error If the file could not be opened.
      */
-    char detect_delimiter(std::string filepath)
+    char detect_delimiter(std::string line)
     {
-        // Open the given file, read the first line
-        std::ifstream fin;
-        fin.exceptions(std::ofstream::badbit);
-        try
-        {
-            fin.open(filepath);
-        }
-        catch (const std::ifstream::failure &e)
-        {
-            throw std::runtime_error("Unable to open file " + filepath);
-        }
-
-        std::string line;
-        std::getline(fin, line);
-
         char delims[] = {',', ';', ' ', '\t'};
         unsigned counts[] = {0, 0, 0, 0};
         unsigned delims_length = (sizeof(delims) / sizeof(char));
 
-        for (unsigned c = 0; c < line.length() - 1; ++c)
+        for (unsigned c = 0; c + 1 < line.length(); ++c)
         {
             // Skip through all values inside quotes
             if (line[c] == '"')
@@ -93,8 +131,50 @@ namespace FileIO
         return delims[most_frequent];
     }
 
+    /*
+     * Whether the given path names a gzip-compressed file.
+     */
+    bool is_gzip(std::string filepath)
+    {
+        return filepath.size() > 3 && filepath.compare(filepath.size() - 3, 3, ".gz") == 0;
+    }
+
+    /**
+     * The number of bytes of text in the given input file, once decompressed if it is gzip-compressed.
+     * A gzip file records its uncompressed size only modulo 4 GiB, so that size is raised by 4 GiB at
+     * a time until it is at least the compressed size, which text never compresses beyond.
+     *
+     * @param filepath The input file.
+     *
+     * @return The size of the file's text in bytes, or 0 if it cannot be read.
+     */
+    std::size_t input_size(std::string filepath)
+    {
+        std::error_code error;
+        std::size_t size = std::filesystem::file_size(filepath, error);
+        if (error)
+        {
+            return 0;
+        }
+        if (!is_gzip(filepath) || size < 4)
+        {
+            return size;
+        }
+
+        std::ifstream fin(filepath, std::ios::binary);
+        unsigned char trailer[4] = {0, 0, 0, 0};
+        fin.seekg(-4, std::ios::end);
+        fin.read(reinterpret_cast<char *>(trailer), 4);
+        std::size_t uncompressed = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (std::size_t(trailer[3]) << 24);
+        while (uncompressed < size)
+        {
+            uncompressed += std::size_t(1) << 32;
+        }
+        return uncompressed;
+    }
+
     /**
-     * Returns the truncated name of the file.
+     * Returns the truncated name of the file, without any .gz suffix.
      *
      * @param filepath The filepath to truncate.
      * @param given_name The name to give the file, if nonempty.
@@ -112,6 +192,10 @@ namespace FileIO
             return given_name;
         }
 
+        if (is_gzip(filepath))
+        {
+            filepath.resize(filepath.size() - 3);
+        }
         auto start_index = filepath.find_last_of("/|\\") + 1;
         auto end_index = filepath.find_last_of(".");
         auto filename = filepath.substr(start_index, end_index - start_index);
@@ -234,430 +318,1489 @@ namespace FileIO
         return path;
     }
 
-    /**
-     * Outputs the given string to the given file and std::cout.
-     *
-     * @param filepath The path to the file to write to.
-     *
-     * @throws std::runtime_error If the file could not be opened.
+    /* FILE INPUT */
+
+    const std::size_t ROW_BLOCK = 64; // rows parsed by a thread at once
+
+    /*
+     * A read-only view of a whole file, memory-mapped where the platform allows it.
+     * A gzip-compressed (.gz) file is decompressed a chunk at a time into an anonymous temporary file,
+     * which is mapped instead, so that its text is paged in and out like that of any other input rather
+     * than held in memory whole.
      */
-    void out(std::string filepath, std::string str)
+    class MappedFile
     {
-        std::cout << str << std::flush;
+    public:
+        explicit MappedFile(std::string filepath) : data_(nullptr), size_(0), mapped_(false)
+        {
+            #ifndef _WIN32 // Unix
+            int fd = is_gzip(filepath) ? decompress(filepath) : open(filepath.c_str(), O_RDONLY);
+            struct stat info;
+            if (fd == -1 || fstat(fd, &info) == -1)
+            {
+                if (fd != -1)
+                {
+                    close(fd);
+                }
+                throw std::runtime_error("Unable to open file " + filepath);
+            }
+            size_ = info.st_size;
+            if (size_ > 0)
+            {
+                void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr == MAP_FAILED)
+                {
+                    close(fd);
+                    throw std::runtime_error("Unable to map file " + filepath + ": " + std::strerror(errno));
+                }
+                madvise(addr, size_, MADV_WILLNEED);
+                data_ = static_cast<const char *>(addr);
+                mapped_ = true;
+            }
+            close(fd);
+            #else // Windows
+            if (is_gzip(filepath))
+            {
+                gzFile gz = gzopen(filepath.c_str(), "rb");
+                if (gz == nullptr)
+                {
+                    throw std::runtime_error("Unable to open file " + filepath);
+                }
+                gzbuffer(gz, 1 << 18);
+                std::vector<char> chunk(1 << 20);
+                int n;
+                while ((n = gzread(gz, chunk.data(), chunk.size())) > 0)
+                {
+                    buffer_.append(chunk.data(), n);
+                }
+                gzclose(gz);
+                if (n < 0)
+                {
+                    throw std::runtime_error("Unable to decompress file " + filepath);
+                }
+            }
+            else
+            {
+                std::ifstream fin(filepath, std::ios::binary);
+                if (!fin.good())
+                {
+                    throw std::runtime_error("Unable to open file " + filepath);
+                }
+                buffer_.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+            }
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+            #endif
+            Metrics::add(Metrics::BYTES_READ, size_);
+        }
 
-        std::ofstream fout;
-        fout.exceptions(std::ofstream::badbit);
-        try
+        ~MappedFile()
         {
-            fout.open(filepath, std::ios_base::app);
+            #ifndef _WIN32 // Unix
+            if (mapped_)
+            {
+                munmap(const_cast<char *>(data_), size_);
+            }
+            #endif
         }
-        catch (const std::ofstream::failure &e)
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const char *data() const { return data_; }
+        std::size_t size() const { return size_; }
+
+    private:
+        const char *data_;
+        std::size_t size_;
+        bool mapped_;
+        std::string buffer_;
+
+        #ifndef _WIN32 // Unix
+        /*
+         * Decompress the given file into a temporary file that disappears once closed, returning its descriptor.
+         */
+        static int decompress(std::string filepath)
         {
-            throw std::runtime_error("Unable to write to file " + filepath);
+            gzFile gz = gzopen(filepath.c_str(), "rb");
+            if (gz == nullptr)
+            {
+                throw std::runtime_error("Unable to open file " + filepath);
+            }
+
+            auto path = std::filesystem::temp_directory_path().string() + "/minaa_input_XXXXXX";
+            std::vector<char> name(path.begin(), path.end());
+            name.push_back('\0');
+            int fd = mkstemp(name.data());
+            if (fd == -1)
+            {
+                gzclose(gz);
+                throw std::runtime_error("Unable to create a temporary file to decompress " + filepath + " into");
+            }
+            unlink(name.data());
+
+            gzbuffer(gz, 1 << 18);
+            std::vector<char> chunk(1 << 20);
+            int n;
+            while ((n = gzread(gz, chunk.data(), chunk.size())) > 0)
+            {
+                for (int written = 0, w = 0; written < n; written += w)
+                {
+                    w = write(fd, chunk.data() + written, n - written);
+                    if (w <= 0)
+                    {
+                        std::string reason = std::strerror(errno);
+                        gzclose(gz);
+                        close(fd);
+                        throw std::runtime_error("Unable to decompress file " + filepath + ": " + reason);
+                    }
+                }
+            }
+            gzclose(gz);
+            if (n < 0)
+            {
+                close(fd);
+                throw std::runtime_error("Unable to decompress file " + filepath);
+            }
+            return fd;
         }
-        fout << str;
-        fout.close();
-    }
+        #endif
+    };
 
-    /**
-     * Outputs the given string to the given file and std::cerr.
-     *
-     * @param filepath The path to the file to write to.
-     *
-     * @throws std::runtime_error If the file could not be opened.
+    typedef std::array<const char *, 2> Span; // [begin, end) of a line or cell
+
+    /*
+     * The nonempty lines of the given text, without their line endings.
      */
-    void err(std::string filepath, std::string str)
+    std::vector<Span> split_lines(const char *data, std::size_t size)
     {
-        std::string err_str = "ERROR: " + str + "\nPROGRAM TERMINATING\n";
+        std::vector<Span> lines;
+        auto end = data + size;
+        for (auto p = data; p < end;)
+        {
+            auto eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            auto next = (eol == nullptr) ? end : eol + 1;
+            auto last = (eol == nullptr) ? end : eol;
+            if (last > p && last[-1] == '\r')
+            {
+                --last;
+            }
+            if (last > p)
+            {
+                lines.push_back({p, last});
+            }
+            p = next;
+        }
+        return lines;
+    }
 
-        std::cerr << err_str << std::flush;
+    /*
+     * The end of the cell starting at begin, i.e. the next delimiter in the line or the line's end.
+     */
+    const char *cell_end(const char *begin, const char *line_end, char delim)
+    {
+        auto p = static_cast<const char *>(std::memchr(begin, delim, line_end - begin));
+        return (p == nullptr) ? line_end : p;
+    }
 
-        std::ofstream fout;
-        fout.exceptions(std::ofstream::badbit);
-        try
+    /*
+     * The number at the start of the given cell, after any blanks, or 0 if there is none.
+     */
+    double parse_cell(const char *begin, const char *end)
+    {
+        while (begin < end && (*begin == ' ' || *begin == '\t'))
         {
-            fout.open(filepath, std::ios_base::app);
+            ++begin;
         }
-        catch (const std::ofstream::failure &e)
+        if (begin < end && *begin == '+')
         {
-            throw std::runtime_error("Unable to write to file " + filepath);
+            ++begin;
         }
-        fout << err_str;
-        fout.close();
+        double value = 0;
+        if (std::from_chars(begin, end, value).ec != std::errc())
+        {
+            return 0;
+        }
+        return value;
     }
 
-    /* FILE INPUT */
-
-    /**
-     * Parse the given csv adjacency matrix file into a list
-     *
-     * @param filepath_in the path to the input file.
-     * @param filepath_out the path to the output file.
-     *
-     * @return Path to the GraphCrunch-friendly version of the input graph.
-     *
-     * @throws std::runtime_error If the file could not be opened, or the output file could not be created.
+    /*
+     * Load a network from a dense CSV adjacency matrix, whose first row and column are labels.
+     * Rows are split with a vectorized newline scan and then parsed in parallel.
      */
-    std::string graphcrunch_in(std::string filepath_in, std::string filepath_out)
+    Graph csv_to_graph(const MappedFile &file, std::string filepath, bool keep_weights)
     {
-        // Identify the delimiter for this csv
-        char delim;
-        try
+        auto lines = split_lines(file.data(), file.size());
+        if (lines.empty())
         {
-            delim = detect_delimiter(filepath_in);
+            throw std::runtime_error("File " + filepath + " is empty");
         }
-        catch (const std::runtime_error &e)
+        char delim = detect_delimiter(std::string(lines[0][0], lines[0][1]));
+        auto n = lines.size() - 1;
+
+        // Parse each row into its label and the columns of its nonzero entries
+        Graph graph;
+        graph.labels.resize(n);
+        std::vector<std::vector<unsigned>> adjacency(n);
+        std::vector<std::vector<double>> weights(keep_weights ? n : 0);
+        Util::parallel_for(n, ROW_BLOCK, [&](std::size_t begin, std::size_t end)
         {
-            throw e;
-        }
+            for (auto i = begin; i < end; ++i)
+            {
+                auto [p, line_end] = lines[i + 1];
+                auto q = cell_end(p, line_end, delim);
+                graph.labels[i].assign(p, q);
+                for (unsigned j = 0; q != line_end; ++j)
+                {
+                    p = q + 1;
+                    q = cell_end(p, line_end, delim);
+                    auto value = parse_cell(p, q);
+                    if (value != 0)
+                    {
+                        adjacency[i].push_back(j);
+                        if (keep_weights)
+                        {
+                            weights[i].push_back(value);
+                        }
+                    }
+                }
+            }
+        });
 
-        // Open the input file
-        std::ifstream fin;
-        fin.exceptions(std::ofstream::badbit);
-        try
+        // Pack the rows into CSR form
+        graph.offsets.resize(n + 1, 0);
+        for (std::size_t i = 0; i < n; ++i)
         {
-            fin.open(filepath_in);
+            graph.offsets[i + 1] = graph.offsets[i] + adjacency[i].size();
         }
-        catch (const std::ifstream::failure &e)
+        graph.neighbors.reserve(graph.offsets[n]);
+        graph.weights.reserve(keep_weights ? graph.offsets[n] : 0);
+        for (std::size_t i = 0; i < n; ++i)
         {
-            throw std::runtime_error("Unable to open file " + filepath_in);
+            graph.neighbors.insert(graph.neighbors.end(), adjacency[i].begin(), adjacency[i].end());
+            if (keep_weights)
+            {
+                graph.weights.insert(graph.weights.end(), weights[i].begin(), weights[i].end());
+            }
         }
 
-        // Parse the file into a matrix
-        std::vector<std::vector<double>> matrix;
-        std::string line;
-        while (std::getline(fin, line))
+        return graph;
+    }
+
+    /*
+     * The fields of the given line. Runs of blanks count as one separator when the delimiter is blank.
+     */
+    std::vector<Span> split_fields(Span line, char delim)
+    {
+        std::vector<Span> fields;
+        auto [p, end] = line;
+        if (delim == ' ' || delim == '\t')
         {
-            std::stringstream ss(line);
-            std::string cell;
-            std::vector<double> row;
-            while (std::getline(ss, cell, delim))
+            while (true)
             {
-                try
+                while (p < end && (*p == ' ' || *p == '\t'))
+                {
+                    ++p;
+                }
+                if (p == end)
                 {
-                    row.push_back(std::stod(cell));
+                    break;
                 }
-                catch (std::invalid_argument const &)
+                auto q = p;
+                while (q < end && *q != ' ' && *q != '\t')
                 {
-                    row.push_back(0);
+                    ++q;
                 }
+                fields.push_back({p, q});
+                p = q;
             }
-            matrix.push_back(row);
         }
-
-        // Convert the matrix into a list
-        std::vector<std::array<unsigned, 2>> list;
-        for (unsigned i = 1; i < matrix.size(); ++i)
+        else
         {
-            for (unsigned j = i; j < matrix[i].size(); ++j)
+            for (auto q = cell_end(p, end, delim);; q = cell_end(p, end, delim))
             {
-                if (matrix[i][j] != 0)
+                fields.push_back({p, q});
+                if (q == end)
                 {
-                    list.push_back({i, j});
+                    break;
                 }
+                p = q + 1;
             }
         }
-
-        // Open the output file
-        std::string out_filepath = filepath_out + "_gc.csv";
-        std::ofstream outfile;
-        outfile.exceptions(std::ofstream::badbit);
-        try
-        {
-            outfile.open(out_filepath);
-        }
-        catch (const std::ofstream::failure &e)
-        {
-            throw std::runtime_error("Unable to open file " + out_filepath);
-        }
-
-        // Write the list to a file
-        outfile << (matrix.size() - 1) << std::endl;
-        outfile << list.size() << std::endl;
-        for (auto &row : list)
-        {
-            outfile << row[0] << " " << row[1] << std::endl;
-        }
-        outfile.close();
-
-        return out_filepath;
+        return fields;
     }
 
-    /**
-     * Parse the file at the given path into a matrix.
-     * Require that the file is a CSV, and that the first row and column are labels.
-     *
-     * @param filepath The graph file to parse into a matrix.
-     *
-     * @return A matrix containing the data elements of the given file.
-     *
-     * @throws std::runtime_error If the file could not be opened.
+    /*
+     * Pack edges into a CSR graph: an undirected edge appears in the rows of both its ends, and a directed
+     * one, an entry of the adjacency matrix, only in the row of its source. Rows are sorted, and repeated
+     * edges keep their first weight.
      */
-    std::vector<std::vector<double>> file_to_matrix(std::string filepath)
+    Graph pack_edges(std::vector<std::string> labels, const std::vector<std::array<unsigned, 2>> &edges,
+                     const std::vector<double> &weights, bool keep_weights, bool is_undirected = true)
     {
-        // Identify the delimiter for this csv
-        char delim;
-        try
-        {
-            delim = detect_delimiter(filepath);
-        }
-        catch (const std::runtime_error &e)
-        {
-            throw e;
-        }
+        auto n = labels.size();
 
-        // Open the input file
-        std::ifstream fin;
-        fin.exceptions(std::ofstream::badbit);
-        try
+        std::vector<std::size_t> offsets(n + 1, 0);
+        for (auto &edge : edges)
         {
-            fin.open(filepath);
+            ++offsets[edge[0] + 1];
+            if (is_undirected && edge[0] != edge[1])
+            {
+                ++offsets[edge[1] + 1];
+            }
         }
-        catch (const std::ifstream::failure &e)
+        for (std::size_t i = 0; i < n; ++i)
         {
-            throw std::runtime_error("Unable to open file " + filepath);
+            offsets[i + 1] += offsets[i];
         }
 
-        // Parse the file directly into a matrix, skipping the first row and column
-        std::vector<std::vector<double>> matrix;
-        std::string line;
-        auto first_row = true;
-        while (std::getline(fin, line))
+        std::vector<std::pair<unsigned, double>> entries(offsets[n]);
+        auto cursor = offsets;
+        for (std::size_t e = 0; e < edges.size(); ++e)
         {
-            if (first_row)
+            auto [u, v] = edges[e];
+            entries[cursor[u]++] = {v, weights[e]};
+            if (is_undirected && u != v)
             {
-                first_row = false;
-                continue;
+                entries[cursor[v]++] = {u, weights[e]};
             }
+        }
 
-            std::stringstream ss(line);
-            std::string cell;
-            std::vector<double> row;
-            auto first_col = true;
-            while (std::getline(ss, cell, delim))
+        Graph graph;
+        graph.labels = std::move(labels);
+        graph.offsets.resize(n + 1, 0);
+        graph.neighbors.reserve(entries.size());
+        graph.weights.reserve(keep_weights ? entries.size() : 0);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto first = entries.begin() + offsets[i];
+            auto last = entries.begin() + offsets[i + 1];
+            std::stable_sort(first, last, [](const auto &a, const auto &b) { return a.first < b.first; });
+            for (auto it = first; it != last; ++it)
             {
-                if (first_col)
+                if (it != first && it->first == (it - 1)->first)
                 {
-                    first_col = false;
                     continue;
                 }
-
-                try
-                {
-                    row.push_back(std::stod(cell));
-                }
-                catch (std::invalid_argument const &)
+                graph.neighbors.push_back(it->first);
+                if (keep_weights)
                 {
-                    row.push_back(0);
+                    graph.weights.push_back(it->second);
                 }
             }
-            matrix.push_back(row);
+            graph.offsets[i + 1] = graph.neighbors.size();
         }
 
-        return matrix;
+        return graph;
     }
 
-    /**
-     * Parse the labels from the given file into a vector.
-     *
-     * @param filepath The file to parse the labels from.
-     *
-     * @return The labels from the given file.
-     *
-     * @throws std::runtime_error If the file could not be opened.
+    /*
+     * Load a network from an edge list: one edge per line as "source target [weight]", where nodes are
+     * named by their labels and numbered in order of first appearance. Lines starting with # or % are
+     * comments. Edges of weight 0 are dropped, and a missing weight is 1.
      */
-    std::vector<std::string> parse_labels(std::string filepath)
+    Graph edge_list_to_graph(const MappedFile &file, std::string filepath, bool keep_weights)
     {
-        std::ifstream fin;
-        fin.exceptions(std::ofstream::badbit);
-        try
+        auto lines = split_lines(file.data(), file.size());
+
+        std::vector<std::string> labels;
+        std::unordered_map<std::string, unsigned> ids;
+        auto id = [&](Span field)
         {
-            fin.open(filepath);
-        }
-        catch (const std::ifstream::failure &e)
+            auto [it, inserted] = ids.try_emplace(std::string(field[0], field[1]), labels.size());
+            if (inserted)
+            {
+                labels.push_back(it->first);
+            }
+            return it->second;
+        };
+
+        std::vector<std::array<unsigned, 2>> edges;
+        std::vector<double> weights;
+        char delim = 0;
+        for (std::size_t l = 0; l < lines.size(); ++l)
         {
-            throw std::runtime_error("Unable to open file " + filepath);
+            if (*lines[l][0] == '#' || *lines[l][0] == '%')
+            {
+                continue;
+            }
+            if (delim == 0)
+            {
+                delim = detect_delimiter(std::string(lines[l][0], lines[l][1]));
+            }
+
+            auto fields = split_fields(lines[l], delim);
+            if (fields.size() < 2)
+            {
+                throw std::runtime_error("Line " + std::to_string(l + 1) + " of " + filepath + " is not an edge");
+            }
+            auto weight = (fields.size() > 2) ? parse_cell(fields[2][0], fields[2][1]) : 1;
+            auto u = id(fields[0]);
+            auto v = id(fields[1]);
+            if (weight != 0)
+            {
+                edges.push_back({u, v});
+                weights.push_back(weight);
+            }
         }
 
-        std::vector<std::string> labels;
-        std::string line;
-        std::getline(fin, line);
-        while (std::getline(fin, line))
+        if (labels.empty())
         {
-            std::stringstream ss(line);
-            std::string cell;
-            std::getline(ss, cell, ',');
-            labels.push_back(cell);
+            throw std::runtime_error("File " + filepath + " contains no edges");
         }
-
-        return labels;
+        return pack_edges(std::move(labels), edges, weights, keep_weights);
     }
 
-    /* FILE OUTPUT */
-
-    /**
-     * Write graph to a file.
-     *
-     * @param filepath The path to the file to write the graph to.
-     * @param labels The labels for the graph.
-     * @param graph The graph to write to the file.
+    /*
+     * Whether the given file holds an edge list rather than a dense adjacency matrix, judged by its content:
+     * an edge list has 2 or 3 fields per line, where a matrix has a corner and a label per node in its
+     * header, then a row per node. Only a matrix of 1 or 2 nodes also has that few fields, so the lines are
+     * only split when the header is that short; such a file is a matrix if it is square with an empty
+     * corner, and ambiguous if it is square otherwise.
      *
-     * @throws std::runtime_error If the file could not be written.
+     * Throws std::runtime_error if the file could be either.
      */
-    void graph_to_file(std::string filepath, std::vector<std::string> labels, std::vector<std::vector<unsigned>> graph)
+    bool is_edge_list(const MappedFile &file, std::string filepath)
     {
-        std::ofstream fout;
-        fout.exceptions(std::ofstream::badbit);
-        try
+        if (file.size() == 0)
         {
-            fout.open(filepath);
+            return false;
         }
-        catch (const std::ofstream::failure &e)
+        if (*file.data() == '#' || *file.data() == '%')
         {
-            throw std::runtime_error("Unable to open file " + filepath);
+            return true; // a comment, which a matrix cannot start with
         }
 
-        // Write the labels
-        fout << "\"\"";
-        for (unsigned i = 0; i < labels.size(); ++i)
+        auto eol = static_cast<const char *>(std::memchr(file.data(), '\n', file.size()));
+        Span first = {file.data(), (eol == nullptr) ? file.data() + file.size() : eol};
+        if (first[1] > first[0] && first[1][-1] == '\r')
         {
-            fout << "," << labels[i];
+            --first[1];
         }
-        fout << std::endl;
-
-        // Write the graph
-        for (unsigned i = 0; i < graph.size(); ++i)
+        auto header = split_fields(first, detect_delimiter(std::string(first[0], first[1])));
+        if (header.size() < 2 || header.size() > 3)
         {
-            fout << labels[i];
-            for (unsigned j = 0; j < graph[i].size(); ++j)
-            {
-                fout << "," << graph[i][j];
-            }
-            fout << std::endl;
+            return false;
         }
 
-        fout.close();
+        auto lines = split_lines(file.data(), file.size());
+        if (lines.size() != header.size())
+        {
+            return true;
+        }
+        std::string corner(header[0][0], header[0][1]);
+        if (corner == "" || corner == "\"\"")
+        {
+            return false;
+        }
+        throw std::runtime_error("File " + filepath + " could be either an edge list or an adjacency matrix; " +
+                                 "name an edge list .edges, or leave the corner of a matrix empty");
     }
 
-    /**
-     * Write GDVs to a file.
-     *
-     * @param filepath The path to the file to write the GDVs to.
-     * @param labels The labels for the GDVs.
-     * @param gdvs The GDVs to write to the file.
-     *
-     * @throws std::runtime_error If the file could not be written.
+    /*
+     * Load a network from a Matrix Market coordinate file. Nodes are labelled by their 1-based indices,
+     * and explicit zeros are dropped. A symmetric matrix stores one triangle of an undirected network, so
+     * each entry is an edge both ways; a general matrix is read entry for entry, as the same dense CSV
+     * would be, so only the entries in its upper triangle are edges.
      */
-    void gdvs_to_file(std::string filepath, std::vector<std::string> labels, std::vector<std::vector<unsigned>> gdvs)
+    Graph matrix_market_to_graph(const MappedFile &file, std::string filepath, bool keep_weights)
     {
-        std::ofstream fout;
-        fout.exceptions(std::ofstream::badbit);
-        try
+        auto lines = split_lines(file.data(), file.size());
+        auto invalid = [&](std::string why)
+        {
+            return std::runtime_error("File " + filepath + " is not a supported Matrix Market file: " + why);
+        };
+        auto to_index = [&](Span field)
+        {
+            unsigned long value = 0;
+            auto [end, ec] = std::from_chars(field[0], field[1], value);
+            if (ec != std::errc() || end != field[1])
+            {
+                throw invalid("bad index " + std::string(field[0], field[1]));
+            }
+            return value;
+        };
+
+        // The banner, e.g. "%%MatrixMarket matrix coordinate real symmetric"
+        if (lines.empty())
         {
-            fout.open(filepath);
+            throw invalid("missing banner");
         }
-        catch (const std::ofstream::failure &e)
+        auto banner = split_fields(lines[0], ' ');
+        std::vector<std::string> words;
+        for (auto &field : banner)
         {
-            throw std::runtime_error("Unable to open file " + filepath);
+            std::string word(field[0], field[1]);
+            std::transform(word.begin(), word.end(), word.begin(), [](unsigned char c) { return std::tolower(c); });
+            words.push_back(word);
         }
-
-        for (unsigned i = 0; i < labels.size(); ++i)
+        if (words.size() < 5 || words[1] != "matrix")
         {
-            fout << labels[i];
-            for (unsigned j = 0; j < gdvs[i].size(); ++j)
-            {
-                fout << "," << gdvs[i][j];
-            }
-            fout << std::endl;
+            throw invalid("missing banner");
         }
+        if (words[2] != "coordinate")
+        {
+            throw invalid("only the coordinate format is supported");
+        }
+        if (words[3] != "real" && words[3] != "integer" && words[3] != "pattern")
+        {
+            throw invalid("unsupported field " + words[3]);
+        }
+        auto is_pattern = (words[3] == "pattern");
+        if (words[4] != "general" && words[4] != "symmetric")
+        {
+            throw invalid("unsupported symmetry " + words[4]);
+        }
+        auto is_symmetric = (words[4] == "symmetric");
 
-        fout.close();
-    }
-
-    /**
-     * Write the cost matrix to a file.
+        // The size line, then the entries
+        std::size_t l = 1;
+        while (l < lines.size() && *lines[l][0] == '%')
+        {
+            ++l;
+        }
+        if (l == lines.size())
+        {
+            throw invalid("missing size line");
+        }
+        auto size = split_fields(lines[l++], ' ');
+        if (size.size() != 3)
+        {
+            throw invalid("bad size line");
+        }
+        auto rows = to_index(size[0]);
+        auto cols = to_index(size[1]);
+        auto n = std::max(rows, cols);
+
+        std::vector<std::array<unsigned, 2>> edges;
+        std::vector<double> weights;
+        edges.reserve(to_index(size[2]));
+        weights.reserve(to_index(size[2]));
+        for (; l < lines.size(); ++l)
+        {
+            if (*lines[l][0] == '%')
+            {
+                continue;
+            }
+            auto fields = split_fields(lines[l], ' ');
+            if (fields.size() < (is_pattern ? 2u : 3u))
+            {
+                throw invalid("bad entry on line " + std::to_string(l + 1));
+            }
+            auto i = to_index(fields[0]);
+            auto j = to_index(fields[1]);
+            if (i < 1 || i > rows || j < 1 || j > cols)
+            {
+                throw invalid("entry out of range on line " + std::to_string(l + 1));
+            }
+            auto weight = is_pattern ? 1 : parse_cell(fields[2][0], fields[2][1]);
+            if (weight != 0)
+            {
+                edges.push_back({unsigned(i - 1), unsigned(j - 1)});
+                weights.push_back(weight);
+            }
+        }
+
+        std::vector<std::string> labels(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            labels[i] = std::to_string(i + 1);
+        }
+        return pack_edges(std::move(labels), edges, weights, keep_weights, is_symmetric);
+    }
+
+    const char CSR_MAGIC[8] = {'M', 'I', 'N', 'A', 'A', 'C', 'S', 'R'};
+    const std::uint32_t CSR_VERSION = 1;
+    const std::uint32_t CSR_WEIGHTED = 1;
+
+    /*
+     * The fixed-size header of a binary CSR file. It is followed by offsets (n + 1 uint64), neighbors
+     * (nnz uint32), weights (nnz double, if weighted), and the labels (each a uint32 length, then its bytes),
+     * all in native byte order.
+     */
+    struct CsrHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t flags;
+        std::uint64_t n;
+        std::uint64_t nnz;
+    };
+
+    /*
+     * Load a network from a binary CSR file written by graph_to_binary_file. The arrays are copied
+     * straight out of the mapped file, with no parsing.
+     */
+    Graph binary_to_graph(const MappedFile &file, std::string filepath, bool keep_weights)
+    {
+        auto invalid = std::runtime_error("File " + filepath + " is not a valid binary CSR graph");
+        auto p = file.data();
+        auto end = file.data() + file.size();
+        auto take = [&](void *dst, std::size_t bytes)
+        {
+            if (std::size_t(end - p) < bytes)
+            {
+                throw invalid;
+            }
+            std::memcpy(dst, p, bytes);
+            p += bytes;
+        };
+
+        CsrHeader header;
+        take(&header, sizeof(header));
+        if (std::memcmp(header.magic, CSR_MAGIC, sizeof(CSR_MAGIC)) != 0 || header.version != CSR_VERSION)
+        {
+            throw invalid;
+        }
+        // Reject sizes the file cannot possibly hold before allocating for them
+        if (header.n >= file.size() || header.nnz >= file.size())
+        {
+            throw invalid;
+        }
+
+        Graph graph;
+        std::vector<std::uint64_t> offsets(header.n + 1);
+        take(offsets.data(), offsets.size() * sizeof(std::uint64_t));
+        graph.offsets.assign(offsets.begin(), offsets.end());
+        graph.neighbors.resize(header.nnz);
+        take(graph.neighbors.data(), graph.neighbors.size() * sizeof(unsigned));
+        if (header.flags & CSR_WEIGHTED)
+        {
+            if (keep_weights)
+            {
+                graph.weights.resize(header.nnz);
+                take(graph.weights.data(), graph.weights.size() * sizeof(double));
+            }
+            else
+            {
+                if (std::size_t(end - p) < header.nnz * sizeof(double))
+                {
+                    throw invalid;
+                }
+                p += header.nnz * sizeof(double);
+            }
+        }
+        graph.labels.resize(header.n);
+        for (auto &label : graph.labels)
+        {
+            std::uint32_t length;
+            take(&length, sizeof(length));
+            if (std::size_t(end - p) < length)
+            {
+                throw invalid;
+            }
+            label.assign(p, length);
+            p += length;
+        }
+
+        if (graph.offsets[0] != 0 || graph.offsets[header.n] != header.nnz ||
+            !std::is_sorted(graph.offsets.begin(), graph.offsets.end()) ||
+            std::any_of(graph.neighbors.begin(), graph.neighbors.end(), [&](unsigned v) { return v >= header.n; }))
+        {
+            throw invalid;
+        }
+        return graph;
+    }
+
+    /**
+     * Load the network in the given file, whose format is detected from its header or extension:
+     *   - a binary CSR file (starts with the MINAACSR magic, conventionally .csr);
+     *   - a Matrix Market coordinate file (starts with %%MatrixMarket, conventionally .mtx);
+     *   - an edge list (.edges, .edgelist, or .el, or any file whose lines have 2 or 3 fields);
+     *   - otherwise, a dense CSV adjacency matrix whose first row and column are labels.
+     * The edges of a network are the nonzero entries in the upper triangle of its adjacency matrix. Edge
+     * lists and symmetric Matrix Market files are undirected, so each edge is entered both ways, while a
+     * general Matrix Market file, like a dense CSV, is read as given. Sparse formats are parsed in time and
+     * memory that scale with the edges rather than V^2.
      *
-     * @param filepath The path to the file to write the cost matrix to.
-     * @param g_labels Labels for the G graph.
-     * @param h_labels Labels for the H graph.
-     * @param matrix The matrix to write to the file.
+     * @param filepath The graph file to load.
+     * @param keep_weights Whether to keep the value of each nonzero entry as the weight of its edge.
+     *
+     * @return The labels and the binarified adjacency of the network, as a CSR graph.
+     *
+     * @throws std::runtime_error If the file could not be opened, is empty, is malformed, or could be read
+     * as either an edge list or a dense matrix.
+     */
+    Graph file_to_graph(std::string filepath, bool keep_weights)
+    {
+        MappedFile file(filepath);
+        auto starts_with = [&](const char *prefix, std::size_t length)
+        {
+            return file.size() >= length && std::memcmp(file.data(), prefix, length) == 0;
+        };
+        auto stem = is_gzip(filepath) ? filepath.substr(0, filepath.size() - 3) : filepath;
+        auto extension = stem.substr(std::min(stem.size(), stem.find_last_of('.')));
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+        if (starts_with(CSR_MAGIC, sizeof(CSR_MAGIC)) || extension == ".csr")
+        {
+            return binary_to_graph(file, filepath, keep_weights);
+        }
+        if (starts_with("%%MatrixMarket", 14) || extension == ".mtx")
+        {
+            return matrix_market_to_graph(file, filepath, keep_weights);
+        }
+        if (extension == ".edges" || extension == ".edgelist" || extension == ".el" || is_edge_list(file, filepath))
+        {
+            return edge_list_to_graph(file, filepath, keep_weights);
+        }
+        return csv_to_graph(file, filepath, keep_weights);
+    }
+
+    /*
+     * The key by which a label is matched across files, ignoring surrounding double quotes.
+     */
+    std::string label_key(const char *begin, const char *end)
+    {
+        if (end - begin >= 2 && *begin == '"' && end[-1] == '"')
+        {
+            ++begin;
+            --end;
+        }
+        return std::string(begin, end);
+    }
+
+    /*
+     * A hash index from label keys to their positions.
+     */
+    std::unordered_map<std::string, std::size_t> index_labels(const std::vector<std::string> &labels)
+    {
+        std::unordered_map<std::string, std::size_t> index;
+        index.reserve(labels.size());
+        for (std::size_t i = 0; i < labels.size(); ++i)
+        {
+            index.emplace(label_key(labels[i].data(), labels[i].data() + labels[i].size()), i);
+        }
+        return index;
+    }
+
+    /*
+     * For each wanted label, its position among the given labels. If any are missing, the first is given
+     * in missing, and the number of wanted labels that were found in found.
+     */
+    std::vector<std::size_t> match_labels(const std::vector<std::string> &wanted, const std::vector<std::string> &labels,
+                                          std::string &missing, std::size_t &found)
+    {
+        auto index = index_labels(labels);
+        std::vector<std::size_t> positions(wanted.size());
+        found = 0;
+        for (std::size_t i = 0; i < wanted.size(); ++i)
+        {
+            auto it = index.find(label_key(wanted[i].data(), wanted[i].data() + wanted[i].size()));
+            if (it == index.end())
+            {
+                if (missing.empty())
+                {
+                    missing = wanted[i];
+                }
+                continue;
+            }
+            positions[i] = it->second;
+            ++found;
+        }
+        return positions;
+    }
+
+    /*
+     * The positions of the nodes of a network among the labels of a biological matrix's rows or columns:
+     * by label, or, if none of the labels are the network's but there is one per node, in the network's
+     * order. Some labels matching but not all is an error, as reading by position would then misplace
+     * every entry of a reordered matrix.
+     */
+    std::vector<std::size_t> layout_axis(const std::vector<std::string> &wanted, const std::vector<std::string> &labels)
+    {
+        std::string missing;
+        std::size_t found;
+        auto positions = match_labels(wanted, labels, missing, found);
+        if (found == wanted.size())
+        {
+            return positions;
+        }
+        if (found == 0 && labels.size() == wanted.size())
+        {
+            std::iota(positions.begin(), positions.end(), 0);
+            return positions;
+        }
+        throw std::runtime_error("The biological matrix has no row or column for node " + missing);
+    }
+
+    /*
+     * Where the entries needed for G and H lie in a dense CSV biological matrix.
+     */
+    struct DenseLayout
+    {
+        std::vector<Span> lines;
+        char delim;
+        std::size_t cols;                // the number of columns in the file
+        std::vector<std::size_t> row_of; // the file's row for each node of G
+        std::vector<std::size_t> col_of; // the file's column for each node of H
+        bool in_order;                   // whether the needed columns are the file's first ones, in order
+    };
+
+    /*
+     * Index a dense CSV matrix whose first row and column are labels.
+     * Rows and columns are matched to the nodes of G and H by label, so the file may list a superset of
+     * them in any order. Rows (or columns) labelled with none of the labels of G (or H), but one per node,
+     * are taken to be in the order of the graph file.
+     */
+    DenseLayout dense_layout(const MappedFile &file, std::string filepath,
+                             const std::vector<std::string> &g_labels, const std::vector<std::string> &h_labels)
+    {
+        DenseLayout layout;
+        layout.lines = split_lines(file.data(), file.size());
+        auto &lines = layout.lines;
+        if (lines.empty())
+        {
+            throw std::runtime_error("File " + filepath + " is empty");
+        }
+        layout.delim = detect_delimiter(std::string(lines[0][0], lines[0][1]));
+        char delim = layout.delim;
+
+        // Read the labels of the file's rows and columns
+        std::vector<std::string> bio_h_labels;
+        for (auto p = cell_end(lines[0][0], lines[0][1], delim); p != lines[0][1];)
+        {
+            auto q = cell_end(p + 1, lines[0][1], delim);
+            bio_h_labels.emplace_back(p + 1, q);
+            p = q;
+        }
+        std::vector<std::string> bio_g_labels(lines.size() - 1);
+        for (std::size_t i = 0; i < bio_g_labels.size(); ++i)
+        {
+            bio_g_labels[i].assign(lines[i + 1][0], cell_end(lines[i + 1][0], lines[i + 1][1], delim));
+        }
+        layout.cols = bio_h_labels.size();
+
+        // Find the file's row for each node of G and column for each node of H
+        layout.row_of = layout_axis(g_labels, bio_g_labels);
+        layout.col_of = layout_axis(h_labels, bio_h_labels);
+        layout.in_order = true;
+        for (std::size_t j = 0; j < layout.col_of.size(); ++j)
+        {
+            layout.in_order &= (layout.col_of[j] == j);
+        }
+        return layout;
+    }
+
+    /*
+     * Parse the entries of G's node i for each node of H into out.
+     * Unless the needed columns are in order, row is used to hold the file's whole row.
+     */
+    void parse_dense_row(const DenseLayout &layout, std::size_t i, double *out, std::vector<double> &row)
+    {
+        auto width = layout.in_order ? layout.col_of.size() : layout.cols;
+        row.resize(layout.in_order ? 0 : width);
+        auto *cells = layout.in_order ? out : row.data();
+        std::fill(cells, cells + width, 0);
+
+        auto [p, line_end] = layout.lines[layout.row_of[i] + 1];
+        auto q = cell_end(p, line_end, layout.delim);
+        for (std::size_t j = 0; j < width && q != line_end; ++j)
+        {
+            p = q + 1;
+            q = cell_end(p, line_end, layout.delim);
+            cells[j] = parse_cell(p, q);
+        }
+
+        if (!layout.in_order)
+        {
+            for (std::size_t j = 0; j < layout.col_of.size(); ++j)
+            {
+                out[j] = row[layout.col_of[j]];
+            }
+        }
+    }
+
+    /*
+     * Load a biological matrix from a dense CSV matrix whose first row and column are labels.
+     * Only the rows needed are parsed, in parallel.
+     */
+    CostMatrix dense_to_cost_matrix(const MappedFile &file, std::string filepath, std::string scratch_dir,
+                                    const std::vector<std::string> &g_labels, const std::vector<std::string> &h_labels)
+    {
+        auto layout = dense_layout(file, filepath, g_labels, h_labels);
+
+        // Parse the needed rows in parallel, gathering the needed columns
+        CostMatrix matrix(g_labels.size(), h_labels.size(), 0, scratch_dir);
+        Util::parallel_for(matrix.rows(), ROW_BLOCK, [&](std::size_t begin, std::size_t end)
+        {
+            std::vector<double> row;
+            for (auto i = begin; i < end; ++i)
+            {
+                parse_dense_row(layout, i, matrix[i], row);
+            }
+            matrix.release(begin, end);
+        });
+
+        return matrix;
+    }
+
+    /*
+     * Load a biological matrix from (g_label, h_label, value) triplets, one per line. Lines starting with
+     * # are comments, and a first line without a numeric value is a header. Triplets for taxa not in G or
+     * H are ignored, and later triplets for a pair replace earlier ones. Pairs with no triplet are given
+     * the least similar observed value: the maximum for costs, or the minimum for similarities.
+     */
+    CostMatrix triplets_to_cost_matrix(const MappedFile &file, std::string filepath, std::string scratch_dir,
+                                       const std::vector<std::string> &g_labels, const std::vector<std::string> &h_labels,
+                                       bool is_similarity)
+    {
+        auto lines = split_lines(file.data(), file.size());
+        auto g_index = index_labels(g_labels);
+        auto h_index = index_labels(h_labels);
+
+        struct Triplet
+        {
+            std::size_t g;
+            std::size_t h;
+            double value;
+        };
+        std::vector<Triplet> triplets;
+        auto min = std::numeric_limits<double>::infinity();
+        auto max = -std::numeric_limits<double>::infinity();
+        char delim = 0;
+        auto first = true;
+        for (std::size_t l = 0; l < lines.size(); ++l)
+        {
+            if (*lines[l][0] == '#')
+            {
+                continue;
+            }
+            if (delim == 0)
+            {
+                delim = detect_delimiter(std::string(lines[l][0], lines[l][1]));
+            }
+
+            auto fields = split_fields(lines[l], delim);
+            double value = 0;
+            auto numeric = fields.size() >= 3 &&
+                           std::from_chars(fields[2][0], fields[2][1], value).ec == std::errc();
+            if (!numeric)
+            {
+                if (first)
+                {
+                    first = false;
+                    continue;
+                }
+                throw std::runtime_error("Line " + std::to_string(l + 1) + " of " + filepath + " is not a triplet");
+            }
+            first = false;
+
+            auto g = g_index.find(label_key(fields[0][0], fields[0][1]));
+            auto h = h_index.find(label_key(fields[1][0], fields[1][1]));
+            if (g != g_index.end() && h != h_index.end())
+            {
+                triplets.push_back({g->second, h->second, value});
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+        }
+        if (triplets.empty())
+        {
+            throw std::runtime_error("File " + filepath + " has no triplets for nodes of G and H");
+        }
+
+        CostMatrix matrix(g_labels.size(), h_labels.size(), is_similarity ? min : max, scratch_dir);
+        for (auto &triplet : triplets)
+        {
+            matrix[triplet.g][triplet.h] = triplet.value;
+        }
+        return matrix;
+    }
+
+    /*
+     * Whether the given biological file is a list of triplets, rather than a dense matrix.
+     */
+    bool is_triplets(std::string filepath)
+    {
+        auto stem = is_gzip(filepath) ? filepath.substr(0, filepath.size() - 3) : filepath;
+        return stem.size() > 9 && stem.compare(stem.size() - 9, 9, ".triplets") == 0;
+    }
+
+    /**
+     * Load the biological matrix for aligning G to H, optionally stored out of core.
+     * The file is either a dense CSV whose first row and column are labels, or, if its name ends in
+     * .triplets, a list of (g_label, h_label, value) triplets. Entries are matched to the nodes of G and H
+     * by label, so the file may cover a superset of them, in any order.
+     *
+     * @param filepath The matrix file to parse.
+     * @param scratch_dir If nonempty, the directory in which to store the matrix out of core.
+     * @param g_labels The labels of G, which index the rows of the result.
+     * @param h_labels The labels of H, which index the columns of the result.
+     * @param is_similarity Whether the values are similarities rather than costs.
+     *
+     * @return A |G| x |H| cost matrix containing the data elements of the given file.
+     *
+     * @throws std::runtime_error If the file could not be opened, is malformed, or does not cover G and H.
+     */
+    CostMatrix file_to_cost_matrix(std::string filepath, std::string scratch_dir, const std::vector<std::string> &g_labels,
+                                   const std::vector<std::string> &h_labels, bool is_similarity)
+    {
+        MappedFile file(filepath);
+        if (is_triplets(filepath))
+        {
+            return triplets_to_cost_matrix(file, filepath, scratch_dir, g_labels, h_labels, is_similarity);
+        }
+        return dense_to_cost_matrix(file, filepath, scratch_dir, g_labels, h_labels);
+    }
+
+    /**
+     * Stream the biological matrix for aligning G to H, a band of rows at a time, without storing it.
+     * Each band is parsed straight from the (memory-mapped) file into a buffer of a few rows, so only the
+     * bands in flight are ever resident; calling this again rereads the file. Bands are handed to fn in
+     * parallel, in no particular order. A triplet file cannot be read by rows, so it is loaded first, out
+     * of core if a scratch directory is given, and then handed out band by band.
+     *
+     * @param filepath The matrix file to parse.
+     * @param scratch_dir If nonempty, the directory in which to store a triplet file's matrix out of core.
+     * @param g_labels The labels of G, which index the rows.
+     * @param h_labels The labels of H, which index the columns.
+     * @param is_similarity Whether the values are similarities rather than costs.
+     * @param fn Called with (begin, end, rows) for each band of rows [begin, end), where rows holds the
+     *           band's |H| entries per row, contiguously. fn may overwrite rows.
+     *
+     * @throws std::runtime_error If the file could not be opened, is malformed, or does not cover G and H.
+     */
+    void scan_cost_matrix(std::string filepath, std::string scratch_dir, const std::vector<std::string> &g_labels,
+                          const std::vector<std::string> &h_labels, bool is_similarity,
+                          const std::function<void(std::size_t, std::size_t, double *)> &fn)
+    {
+        MappedFile file(filepath);
+        if (is_triplets(filepath))
+        {
+            auto matrix = triplets_to_cost_matrix(file, filepath, scratch_dir, g_labels, h_labels, is_similarity);
+            Util::parallel_for(matrix.rows(), ROW_BLOCK, [&](std::size_t begin, std::size_t end)
+            {
+                fn(begin, end, matrix[begin]);
+                matrix.release(begin, end);
+            });
+            return;
+        }
+
+        auto layout = dense_layout(file, filepath, g_labels, h_labels);
+        auto cols = h_labels.size();
+        Util::parallel_for(g_labels.size(), ROW_BLOCK, [&](std::size_t begin, std::size_t end)
+        {
+            std::vector<double> band((end - begin) * cols);
+            std::vector<double> row;
+            for (auto i = begin; i < end; ++i)
+            {
+                parse_dense_row(layout, i, band.data() + (i - begin) * cols, row);
+            }
+            fn(begin, end, band.data());
+        });
+    }
+
+    /*
+     * The NumPy byte order character for the native byte order.
+     */
+    char npy_byte_order()
+    {
+        return (std::endian::native == std::endian::little) ? '<' : '>';
+    }
+
+    /*
+     * The offset of the data of a NumPy .npy file written by this program, checking that it holds a C-order
+     * rows x cols array of the given dtype, whose items are of the given size, and reading its shape.
+     */
+    std::size_t npy_layout(const MappedFile &file, std::string filepath, std::string descr, std::size_t item_size,
+                           std::size_t &rows, std::size_t &cols)
+    {
+        auto invalid = std::runtime_error("File " + filepath + " is not a valid .npy file of " + descr);
+        if (file.size() < 10 || std::memcmp(file.data(), "\x93NUMPY\x01\x00", 8) != 0)
+        {
+            throw invalid;
+        }
+        std::size_t length = static_cast<unsigned char>(file.data()[8]) | (static_cast<unsigned char>(file.data()[9]) << 8);
+        if (10 + length > file.size())
+        {
+            throw invalid;
+        }
+        std::string dict(file.data() + 10, length);
+        auto shape = dict.find("'shape': (");
+        if (dict.find("'descr': '" + descr + "'") == std::string::npos || dict.find("'fortran_order': False") == std::string::npos ||
+            shape == std::string::npos)
+        {
+            throw invalid;
+        }
+
+        const char *p = dict.data() + shape + 10;
+        const char *end = dict.data() + dict.size();
+        auto parsed = std::from_chars(p, end, rows);
+        if (parsed.ec != std::errc() || parsed.ptr == end || *parsed.ptr != ',')
+        {
+            throw invalid;
+        }
+        p = parsed.ptr + 1;
+        while (p < end && *p == ' ')
+        {
+            ++p;
+        }
+        parsed = std::from_chars(p, end, cols);
+        if (parsed.ec != std::errc() || parsed.ptr == end || *parsed.ptr != ')')
+        {
+            throw invalid;
+        }
+        if (cols != 0 && (file.size() - 10 - length) / item_size / cols < rows)
+        {
+            throw invalid;
+        }
+        return 10 + length;
+    }
+
+    /**
+     * Read a cost matrix from a NumPy .npy file of float64, as written by matrix_to_npy_file, copying it
+     * straight out of the mapped file a tile at a time.
+     *
+     * @param filepath The file to read.
+     * @param scratch_dir If nonempty, the directory in which to store the matrix out of core.
+     *
+     * @return The cost matrix.
+     *
+     * @throws std::runtime_error If the file could not be opened, or is not such a file.
+     */
+    CostMatrix npy_file_to_matrix(std::string filepath, std::string scratch_dir)
+    {
+        MappedFile file(filepath);
+        std::size_t rows, cols;
+        auto data = file.data() + npy_layout(file, filepath, std::string(1, npy_byte_order()) + "f8", sizeof(double), rows, cols);
+
+        CostMatrix matrix(rows, cols, 0, scratch_dir);
+        for (std::size_t r = 0; r < rows; r += matrix.tile_rows())
+        {
+            auto end = std::min(rows, r + matrix.tile_rows());
+            std::memcpy(matrix[r], data + r * cols * sizeof(double), (end - r) * cols * sizeof(double));
+            matrix.release(r, end);
+        }
+        return matrix;
+    }
+
+    /**
+     * Read GDVs from a NumPy .npy file of uint32, as written by gdvs_to_npy_file.
+     *
+     * @param filepath The file to read.
+     *
+     * @return The GDVs, one row of orbit counts per node.
+     *
+     * @throws std::runtime_error If the file could not be opened, or is not such a file.
+     */
+    std::vector<std::vector<unsigned>> npy_file_to_gdvs(std::string filepath)
+    {
+        MappedFile file(filepath);
+        std::size_t rows, cols;
+        auto data = file.data() + npy_layout(file, filepath, std::string(1, npy_byte_order()) + "u4", sizeof(std::uint32_t), rows, cols);
+
+        std::vector<std::vector<unsigned>> gdvs(rows, std::vector<unsigned>(cols));
+        for (std::size_t r = 0; r < rows; ++r)
+        {
+            std::memcpy(gdvs[r].data(), data + r * cols * sizeof(std::uint32_t), cols * sizeof(std::uint32_t));
+        }
+        return gdvs;
+    }
+
+    /* FILE OUTPUT */
+
+    /**
+     * Write graph to a file, as a binary adjacency matrix.
+     *
+     * @param filepath The path to the file to write the graph to.
+     * @param graph The graph to write to the file.
      *
      * @throws std::runtime_error If the file could not be written.
      */
-    void matrix_to_file(std::string filepath, std::vector<std::string> g_labels, std::vector<std::string> h_labels,
-                        std::vector<std::vector<double>> matrix)
+    void graph_to_file(std::string filepath, const Graph &graph)
+    {
+        OutputFile fout(filepath);
+
+        // Write the labels
+        fout << "\"\"";
+        for (unsigned i = 0; i < graph.size(); ++i)
+        {
+            fout << "," << graph.labels[i];
+        }
+        fout << '\n';
+
+        // Write the graph
+        std::vector<char> row(graph.size());
+        for (unsigned i = 0; i < graph.size(); ++i)
+        {
+            std::fill(row.begin(), row.end(), 0);
+            for (auto k = graph.offsets[i]; k < graph.offsets[i + 1]; ++k)
+            {
+                if (graph.neighbors[k] < row.size())
+                {
+                    row[graph.neighbors[k]] = 1;
+                }
+            }
+
+            fout << graph.labels[i];
+            for (unsigned j = 0; j < row.size(); ++j)
+            {
+                fout << (row[j] ? ",1" : ",0");
+            }
+            fout << '\n';
+        }
+
+        fout.close();
+    }
+
+    /**
+     * Write graph to a binary CSR file, which file_to_graph loads without parsing.
+     *
+     * @param filepath The path to the file to write the graph to.
+     * @param graph The graph to write to the file.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void graph_to_binary_file(std::string filepath, const Graph &graph)
     {
-        // Create and open the file
         std::ofstream fout;
-        fout.exceptions(std::ofstream::badbit);
+        fout.exceptions(std::ofstream::badbit | std::ofstream::failbit);
         try
         {
-            fout.open(filepath);
+            fout.open(filepath, std::ios::binary);
+
+            CsrHeader header;
+            std::memcpy(header.magic, CSR_MAGIC, sizeof(CSR_MAGIC));
+            header.version = CSR_VERSION;
+            header.flags = graph.weights.empty() ? 0 : CSR_WEIGHTED;
+            header.n = graph.size();
+            header.nnz = graph.neighbors.size();
+
+            std::vector<std::uint64_t> offsets(graph.offsets.begin(), graph.offsets.end());
+            fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            fout.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+            fout.write(reinterpret_cast<const char *>(graph.neighbors.data()), graph.neighbors.size() * sizeof(unsigned));
+            fout.write(reinterpret_cast<const char *>(graph.weights.data()), graph.weights.size() * sizeof(double));
+            for (auto &label : graph.labels)
+            {
+                std::uint32_t length = label.size();
+                fout.write(reinterpret_cast<const char *>(&length), sizeof(length));
+                fout.write(label.data(), length);
+            }
+            Metrics::add(Metrics::BYTES_WRITTEN, fout.tellp());
+            fout.close();
         }
         catch (const std::ofstream::failure &e)
         {
-            throw std::runtime_error("Unable to open file " + filepath);
+            throw std::runtime_error("Unable to write to file " + filepath);
         }
+    }
+
+    /**
+     * Write GDVs to a file.
+     *
+     * @param filepath The path to the file to write the GDVs to.
+     * @param labels The labels for the GDVs.
+     * @param gdvs The GDVs to write to the file.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void gdvs_to_file(std::string filepath, std::vector<std::string> labels, std::vector<std::vector<unsigned>> gdvs)
+    {
+        OutputFile fout(filepath);
+
+        for (unsigned i = 0; i < labels.size(); ++i)
+        {
+            fout << labels[i];
+            for (unsigned j = 0; j < gdvs[i].size(); ++j)
+            {
+                fout << "," << gdvs[i][j];
+            }
+            fout << '\n';
+        }
+
+        fout.close();
+    }
+
+    /**
+     * Write the cost matrix to a file. The cost of a pair pruned before it was evaluated is NA.
+     *
+     * @param filepath The path to the file to write the cost matrix to.
+     * @param g_labels Labels for the G graph.
+     * @param h_labels Labels for the H graph.
+     * @param matrix The matrix to write to the file.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void matrix_to_file(std::string filepath, std::vector<std::string> g_labels, std::vector<std::string> h_labels,
+                        const CostMatrix &matrix)
+    {
+        // Create and open the file
+        OutputFile fout(filepath);
 
         fout << "\"\"";
-        for (unsigned i = 0; i < matrix[0].size(); ++i)
+        for (unsigned i = 0; i < matrix.cols(); ++i)
         {
             fout << "," << h_labels[i];
         }
-        for (unsigned i = 0; i < matrix.size(); ++i)
+        for (unsigned i = 0; i < matrix.rows(); ++i)
         {
-            fout << std::endl
+            fout << '\n'
                  << g_labels[i];
-            for (unsigned j = 0; j < matrix[i].size(); ++j)
+            for (unsigned j = 0; j < matrix.cols(); ++j)
+            {
+                if (std::isnan(matrix[i][j]))
+                {
+                    fout << ",NA";
+                }
+                else
+                {
+                    fout << "," << matrix[i][j];
+                }
+            }
+            if ((i + 1) % matrix.tile_rows() == 0)
             {
-                fout << "," << matrix[i][j];
+                matrix.release(i + 1 - matrix.tile_rows(), i + 1);
             }
         }
 
         fout.close();
     }
 
+    /*
+     * The header of a version 1.0 NumPy .npy file holding a C-order rows x cols array of the given dtype,
+     * padded so that the data that follows it starts on a 64-byte boundary.
+     */
+    std::string npy_header(std::string descr, std::size_t rows, std::size_t cols)
+    {
+        std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (" +
+                           std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+        std::size_t length = 10 + dict.size() + 1; // magic, version and length fields, then the dict and a newline
+        dict.append((64 - length % 64) % 64, ' ');
+        dict += '\n';
+
+        std::string header = "\x93NUMPY";
+        header += char(1); // version 1.0
+        header += char(0);
+        header += char(dict.size() & 0xff); // little-endian uint16 length
+        header += char(dict.size() >> 8);
+        return header + dict;
+    }
+
     /**
-     * Write the given alignment to a csv file as a matrix.
+     * Write labels to a file, one per line, as a sidecar for binary outputs.
      *
-     * @param filepath The path to the output file.
-     * @param g_labels Labels for the G graph.
-     * @param h_labels Labels for the H graph.
-     * @param alignment The alignment matrix to write to the file.
-     * @param similarity_threshold The similarity threshold above which alignments are included in the output.
+     * @param filepath The path to the file to write the labels to.
+     * @param labels The labels to write to the file.
      *
      * @throws std::runtime_error If the file could not be written.
      */
-    void alignment_to_matrix_file(std::string filepath, std::vector<std::string> g_labels,
-                                  std::vector<std::string> h_labels, std::vector<std::vector<double>> alignment, double similarity_threshold)
+    void labels_to_file(std::string filepath, const std::vector<std::string> &labels)
+    {
+        OutputFile fout(filepath);
+
+        for (auto &label : labels)
+        {
+            fout << label << '\n';
+        }
+
+        fout.close();
+    }
+
+    /**
+     * Write the cost matrix to a NumPy .npy file of float64, losslessly and in bulk.
+     * Rows follow the G labels and columns the H labels, as in the label sidecars.
+     *
+     * @param filepath The path to the file to write the cost matrix to.
+     * @param matrix The matrix to write to the file.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void matrix_to_npy_file(std::string filepath, const CostMatrix &matrix)
     {
-        // Create and open the file
         std::ofstream fout;
-        fout.exceptions(std::ofstream::badbit);
+        fout.exceptions(std::ofstream::badbit | std::ofstream::failbit);
         try
         {
-            fout.open(filepath);
+            fout.open(filepath, std::ios::binary);
+            auto header = npy_header(std::string(1, npy_byte_order()) + "f8", matrix.rows(), matrix.cols());
+            fout.write(header.data(), header.size());
+
+            // The matrix is contiguous, so write it a whole tile at a time
+            for (std::size_t r = 0; r < matrix.rows(); r += matrix.tile_rows())
+            {
+                auto end = std::min(matrix.rows(), r + matrix.tile_rows());
+                fout.write(reinterpret_cast<const char *>(matrix[r]), (end - r) * matrix.cols() * sizeof(double));
+                matrix.release(r, end);
+            }
+            Metrics::add(Metrics::BYTES_WRITTEN, fout.tellp());
+            fout.close();
         }
         catch (const std::ofstream::failure &e)
         {
-            throw std::runtime_error("Unable to open file " + filepath);
+            throw std::runtime_error("Unable to write to file " + filepath);
         }
+    }
+
+    /**
+     * Write GDVs to a NumPy .npy file of uint32, with one row of 73 orbit counts per node.
+     *
+     * @param filepath The path to the file to write the GDVs to.
+     * @param gdvs The GDVs to write to the file.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void gdvs_to_npy_file(std::string filepath, const std::vector<std::vector<unsigned>> &gdvs)
+    {
+        std::size_t cols = gdvs.empty() ? 0 : gdvs[0].size();
+
+        std::vector<std::uint32_t> data;
+        data.reserve(gdvs.size() * cols);
+        for (auto &gdv : gdvs)
+        {
+            data.insert(data.end(), gdv.begin(), gdv.end());
+        }
+
+        std::ofstream fout;
+        fout.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+        try
+        {
+            fout.open(filepath, std::ios::binary);
+            auto header = npy_header(std::string(1, npy_byte_order()) + "u4", gdvs.size(), cols);
+            fout.write(header.data(), header.size());
+            fout.write(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(std::uint32_t));
+            Metrics::add(Metrics::BYTES_WRITTEN, fout.tellp());
+            fout.close();
+        }
+        catch (const std::ofstream::failure &e)
+        {
+            throw std::runtime_error("Unable to write to file " + filepath);
+        }
+    }
+
+    /**
+     * Write the given alignment to a csv file as a matrix, streaming it one row at a time.
+     *
+     * @param filepath The path to the output file.
+     * @param g_labels Labels for the G graph.
+     * @param h_labels Labels for the H graph.
+     * @param alignment The alignment to write to the file.
+     * @param similarity_threshold The similarity threshold above which alignments are included in the output.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void alignment_to_matrix_file(std::string filepath, std::vector<std::string> g_labels,
+                                  std::vector<std::string> h_labels, const Assignment &alignment, double similarity_threshold)
+    {
+        // Create and open the file
+        OutputFile fout(filepath);
 
         fout << "\"\"";
-        for (unsigned i = 0; i < alignment[0].size(); ++i)
+        for (unsigned i = 0; i < alignment.cols; ++i)
         {
             fout << "," << h_labels[i];
         }
 
-        for (unsigned i = 0; i < alignment.size(); ++i)
+        for (unsigned i = 0; i < alignment.rows; ++i)
         {
-            fout << std::endl
+            fout << '\n'
                  << g_labels[i];
-            for (unsigned j = 0; j < alignment[0].size(); ++j)
+            for (unsigned j = 0; j < alignment.cols; ++j)
             {
-                if (alignment[i][j] > similarity_threshold)
+                if (j == alignment.match[i] && alignment.similarity[i] > similarity_threshold)
                 {
-                    fout << "," << alignment[i][j];
+                    fout << "," << alignment.similarity[i];
                 }
                 else
                 {
@@ -675,59 +1818,138 @@ namespace FileIO
      * @param filepath The path to the output file.
      * @param g_labels Labels for the G graph.
      * @param h_labels Labels for the H graph.
-     * @param alignment The alignment matrix to write to the file.
+     * @param alignment The alignment to write to the file.
      * @param similarity_threshold The similarity threshold above which alignments are included in the output.
      *
      * @throws std::runtime_error If the file could not be written.
      */
     void alignment_to_list_file(std::string filepath, std::vector<std::string> g_labels,
-                                std::vector<std::string> h_labels, std::vector<std::vector<double>> alignment, double similarity_threshold)
+                                std::vector<std::string> h_labels, const Assignment &alignment, double similarity_threshold)
     {
-        // Convert the alignment matrix into a list
-        std::vector<std::array<double, 3>> list;
+        struct Pair
+        {
+            std::size_t g;
+            std::size_t h;
+            double similarity;
+        };
+
+        // Collect the aligned pairs above the threshold
+        std::vector<Pair> list;
         double net_cost = 0;
-        for (unsigned i = 0; i < alignment.size(); ++i)
+        for (std::size_t i = 0; i < alignment.rows; ++i)
         {
-            for (unsigned j = 0; j < alignment[0].size(); ++j)
+            if (alignment.match[i] != Assignment::NONE && alignment.similarity[i] > similarity_threshold)
             {
-                if (alignment[i][j] > similarity_threshold)
-                {
-                    net_cost += (1 - alignment[i][j]);
-                    list.push_back({(double)i, (double)j, alignment[i][j]});
-                }
+                net_cost += (1 - alignment.similarity[i]);
+                list.push_back({i, alignment.match[i], alignment.similarity[i]});
             }
         }
 
         // Put the list in order of decreasing similarity score
         std::sort(list.begin(), list.end(),
-                  [](const std::array<double, 3> &a, const std::array<double, 3> &b)
+                  [](const Pair &a, const Pair &b)
                   {
-                      return a[2] > b[2];
+                      return a.similarity > b.similarity;
                   });
 
         // Create and open the file
-        std::ofstream fout;
-        fout.exceptions(std::ofstream::badbit);
-        try
-        {
-            fout.open(filepath);
-        }
-        catch (const std::ofstream::failure &e)
-        {
-            throw std::runtime_error("Unable to open file " + filepath);
-        }
+        OutputFile fout(filepath);
 
         // Write the list to a file
         fout << net_cost << ","
              << ""
              << ","
-             << "" << std::endl;
-        for (unsigned i = 0; i < list.size(); ++i)
+             << "" << '\n';
+        for (auto &pair : list)
+        {
+            fout << g_labels[pair.g] << "," << h_labels[pair.h] << "," << pair.similarity << '\n';
+        }
+
+        fout.close();
+    }
+
+
+    /**
+     * Write the candidates of each node of G to a csv file, with rows in the format
+     * g_node,h_node,rank,cost after a header row, and ranks counted from 1. Pairs pruned before they were
+     * evaluated are not candidates, so a node may have fewer than k.
+     *
+     * @param filepath The path to the output file.
+     * @param g_labels Labels for the G graph.
+     * @param h_labels Labels for the H graph.
+     * @param candidates The candidates to write to the file.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void candidates_to_file(std::string filepath, const std::vector<std::string> &g_labels,
+                            const std::vector<std::string> &h_labels, const Candidates &candidates)
+    {
+        OutputFile fout(filepath);
+
+        fout << "g_node,h_node,rank,cost\n";
+        for (std::size_t i = 0; i < candidates.rows; ++i)
+        {
+            for (std::size_t r = 0; r < candidates.k; ++r)
+            {
+                auto c = i * candidates.k + r;
+                if (std::isnan(candidates.cost[c]))
+                {
+                    break; // pruned, as is every candidate after it
+                }
+                fout << g_labels[i] << ',' << h_labels[candidates.match[c]] << ',' << (r + 1) << ',' << candidates.cost[c] << '\n';
+            }
+        }
+
+        fout.close();
+    }
+
+    /**
+     * Write a summary of many alignments to a csv file, with one row per alignment of the cells that
+     * identify it followed by its net cost, after a header row. The net cost of an alignment that failed
+     * is NA.
+     *
+     * @param filepath The path to the output file.
+     * @param columns The header of the cells that identify each alignment, e.g. "g_network,h_network".
+     * @param keys The cells that identify each alignment, in the same format.
+     * @param net_costs The net cost of each alignment, or NaN if it failed.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void summary_to_file(std::string filepath, std::string columns, const std::vector<std::string> &keys,
+                         const std::vector<double> &net_costs)
+    {
+        OutputFile fout(filepath);
+
+        fout << columns << ",net_cost\n";
+        for (std::size_t i = 0; i < net_costs.size(); ++i)
         {
-            fout << g_labels[list[i][0]] << "," << h_labels[list[i][1]] << "," << list[i][2] << std::endl;
+            fout << keys[i] << ',';
+            if (std::isnan(net_costs[i]))
+            {
+                fout << "NA";
+            }
+            else
+            {
+                fout << net_costs[i];
+            }
+            fout << '\n';
         }
 
         fout.close();
     }
 
+    /**
+     * Write the measurements of an alignment to a JSON file.
+     *
+     * @param filepath The path to the output file.
+     * @param metrics The measurements.
+     *
+     * @throws std::runtime_error If the file could not be written.
+     */
+    void metrics_to_file(std::string filepath, const Metrics &metrics)
+    {
+        OutputFile fout(filepath);
+        fout << metrics.to_json();
+        fout.close();
+    }
 }
@@ -2,10 +2,18 @@
 // Topological Similarity Calculator (from GRAAL)
 // Reed Nelson
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <limits>
+#include <numeric>
 #include <vector>
 #include <iostream>
 
+#include "cost_matrix.h"
+#include "dispatch.h"
+#include "metrics.h"
+
 namespace GDVs_Dist
 {
     const double O[73] = {
@@ -18,7 +26,7 @@ namespace GDVs_Dist
         8, 6, 6, 8, 7, 6, 7, 7, 8, 5,
         6, 6, 4};
     const double WEIGHT_SUM = 45.4827;
-    double alpha;
+    const unsigned PRUNE_STRIDE = 8; // orbits summed between lower-bound checks
 
     // // To calculate WEIGHT_SUM:
     // double weight_sum = 0;
@@ -36,53 +44,137 @@ namespace GDVs_Dist
     }
 
     /*
-     * The distance between the ith orbits of nodes v and u.
+     * The orbits in order of decreasing weight, so partial sums of distance grow as fast as possible.
      */
-    double distance(unsigned vi, unsigned ui, unsigned i)
+    std::array<unsigned, 73> orbits_by_weight()
     {
-        double ret = 0;
-        ret = std::log10(vi + 1) - std::log10(ui + 1);
-        ret = std::abs(ret);
-        ret /= std::log10(std::max(vi, ui) + 2);
-        ret *= weight(i);
+        std::array<unsigned, 73> order;
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [](unsigned a, unsigned b)
+                         {
+                             return weight(a) > weight(b);
+                         });
+        return order;
+    }
 
-        return ret;
+    /*
+     * The orbits in their natural order.
+     */
+    std::array<unsigned, 73> orbits_in_order()
+    {
+        std::array<unsigned, 73> order;
+        std::iota(order.begin(), order.end(), 0);
+        return order;
     }
 
     /*
-     * The signature similarity between nodes v and u. (1 - the distance between v and u).
+     * The logarithms of every node's orbit counts, 73 per node, laid out in the given orbit order.
+     * Precomputing these turns the per-pair distance into an element-wise kernel with no calls to log10.
+     * Since log10 is monotonic, log10(max(v, u) + 2) is the larger of the two nodes' log10(count + 2).
      */
-    double similarity(std::vector<unsigned> v, std::vector<unsigned> u)
+    struct Signatures
     {
-        double dist = 0;
-        for (unsigned i = 0; i < 73; ++i)
+        std::vector<double> log1; // log10(count + 1)
+        std::vector<double> log2; // log10(count + 2)
+    };
+
+    Signatures signatures(const std::vector<std::vector<unsigned>> &gdvs, const std::array<unsigned, 73> &order)
+    {
+        Signatures sigs;
+        sigs.log1.resize(gdvs.size() * 73);
+        sigs.log2.resize(gdvs.size() * 73);
+        for (std::size_t n = 0; n < gdvs.size(); ++n)
         {
-            dist += distance(v[i], u[i], i);
+            for (unsigned k = 0; k < 73; ++k)
+            {
+                sigs.log1[n * 73 + k] = std::log10(gdvs[n][order[k]] + 1);
+                sigs.log2[n * 73 + k] = std::log10(gdvs[n][order[k]] + 2);
+            }
         }
+        return sigs;
+    }
 
-        return 1 - (dist / WEIGHT_SUM);
+    /*
+     * The weighted distances between a run of n orbits of nodes v and u.
+     */
+    inline void distances(const double *v1, const double *v2, const double *u1, const double *u2,
+                            const double *weights, double *terms, unsigned n)
+    {
+        for (unsigned k = 0; k < n; ++k)
+        {
+            terms[k] = std::abs(v1[k] - u1[k]) / std::max(v2[k], u2[k]) * weights[k];
+        }
+    }
+
+    /*
+     * The degree term of the cost of aligning nodes v and u.
+     */
+    double node_degs(unsigned v_deg, unsigned u_deg, unsigned g_max_deg, unsigned h_max_deg)
+    {
+        return double(v_deg + u_deg) / (g_max_deg + h_max_deg);
     }
 
     /*
-     * The cost of aligning nodes v and u.
+     * The cost of aligning nodes v and u, abandoned as soon as a lower bound on it exceeds the cutoff.
+     * Every orbit adds a non-negative term to the distance, so summing the heaviest orbits first gives
+     * a lower bound on the cost that only grows; a pruned pair is never evaluated, so its cost is NaN.
      */
-    double cost(std::vector<unsigned> v, std::vector<unsigned> u, unsigned g_max_deg, unsigned h_max_deg)
+    inline double cost(unsigned v_deg, unsigned u_deg, const double *v1, const double *v2, const double *u1, const double *u2,
+                const double *weights, unsigned g_max_deg, unsigned h_max_deg, double alpha, double cutoff)
     {
         // Return maximal cost if either node is a loner
-        if (v[0] == 0 || u[0] == 0)
+        if (v_deg == 0 || u_deg == 0)
         {
             return 1;
         }
 
-        double node_degs = (v[0] + u[0]) / (g_max_deg + h_max_deg);
+        double degs = (1 - alpha) * node_degs(v_deg, u_deg, g_max_deg, h_max_deg);
+
+        double terms[73];
+        double dist = 0;
+        for (unsigned k = 0; k < 73; k += PRUNE_STRIDE)
+        {
+            // The cost if every remaining orbit matched perfectly
+            if (cutoff < 1 && 1 - (degs + alpha * (1 - (dist / WEIGHT_SUM))) > cutoff)
+            {
+                return std::numeric_limits<double>::quiet_NaN();
+            }
+
+            auto n = std::min(PRUNE_STRIDE, 73 - k);
+            distances(v1 + k, v2 + k, u1 + k, u2 + k, weights + k, terms, n);
+            for (unsigned t = 0; t < n; ++t)
+            {
+                dist += terms[t];
+            }
+        }
+
+        return 1 - (degs + alpha * (1 - (dist / WEIGHT_SUM))); // originally 2 - ...
+    }
 
-        return 1 - ((1 - alpha) * node_degs + alpha * similarity(v, u)); // originally 2 - ...
+    /*
+     * The costs of aligning node v of G with every node of H, returning how many were evaluated in full.
+     * This is the hot loop of the cost matrix, so it is the unit that is compiled per instruction set,
+     * with the per-pair work inlined into it.
+     */
+    DISPATCH std::size_t cost_row(double *row, unsigned v_deg, const double *v1, const double *v2,
+                                  const std::vector<std::vector<unsigned>> &h_gdvs, const Signatures &h_sigs,
+                                  const double *weights, unsigned g_max_deg, unsigned h_max_deg, double alpha, double cutoff)
+    {
+        std::size_t evaluated = 0;
+        for (std::size_t j = 0; j < h_gdvs.size(); ++j)
+        {
+            row[j] = cost(v_deg, h_gdvs[j][0], v1, v2, &h_sigs.log1[j * 73], &h_sigs.log2[j * 73],
+                          weights, g_max_deg, h_max_deg, alpha, cutoff);
+            evaluated += !std::isnan(row[j]);
+        }
+        return evaluated;
     }
 
     /*
      * The maximum degree of all the nodes in the given graph.
      */
-    unsigned max_deg(std::vector<std::vector<unsigned>> gdvs)
+    unsigned max_deg(const std::vector<std::vector<unsigned>> &gdvs)
     {
         unsigned max = 0;
         for (unsigned i = 0; i < gdvs.size(); ++i)
@@ -98,30 +190,75 @@ namespace GDVs_Dist
 
     /*
      * Calculate the topological similarity between the graphs at the given paths.
+     * Pairs whose cost provably exceeds the cutoff are not fully evaluated, and are given cost NaN.
+     * The matrix is written tile by tile, in a scratch file under scratch_dir if one is given.
      */
-    std::vector<std::vector<double>> gdvs_dist(
-        std::vector<std::vector<unsigned>> g_gdvs, std::vector<std::vector<unsigned>> h_gdvs, double alpha)
+    CostMatrix gdvs_dist(const std::vector<std::vector<unsigned>> &g_gdvs, const std::vector<std::vector<unsigned>> &h_gdvs,
+                         double alpha, double cutoff, std::string scratch_dir)
     {
-        GDVs_Dist::alpha = alpha;
-
         // Calculate the highest degree among all the nodes in G, H
         unsigned g_max_deg = max_deg(g_gdvs);
         unsigned h_max_deg = max_deg(h_gdvs);
 
         // Initialize the cost matrix to the right dimensions
-        std::vector<std::vector<double>> costs(g_gdvs.size(), std::vector<double>(h_gdvs.size()));
+        CostMatrix costs(g_gdvs.size(), h_gdvs.size(), 0, scratch_dir);
 
-        // cost(g_gdvs[0], h_gdvs[1], g_max_deg, h_max_deg); // DEBUG
+        // Costs never exceed 1, so there is nothing to prune unless the cutoff is lower,
+        // in which case the heaviest orbits are summed first
+        auto order = (cutoff < 1) ? orbits_by_weight() : orbits_in_order();
+        double weights[73];
+        for (unsigned k = 0; k < 73; ++k)
+        {
+            weights[k] = weight(order[k]);
+        }
+        auto g_sigs = signatures(g_gdvs, order);
+        auto h_sigs = signatures(h_gdvs, order);
 
         // Calculate the cost matrix between G and H
-        for (unsigned i = 0; i < g_gdvs.size(); ++i)
+        std::size_t evaluated = 0;
+        for (std::size_t t = 0; t < costs.rows(); t += costs.tile_rows())
+        {
+            auto end = std::min(costs.rows(), t + costs.tile_rows());
+            for (auto i = t; i < end; ++i)
+            {
+                evaluated += cost_row(costs[i], g_gdvs[i][0], &g_sigs.log1[i * 73], &g_sigs.log2[i * 73],
+                                      h_gdvs, h_sigs, weights, g_max_deg, h_max_deg, alpha, cutoff);
+            }
+            costs.release(t, end);
+        }
+
+        Metrics::add(Metrics::COST_PAIRS, evaluated);
+        Metrics::add(Metrics::PRUNED_PAIRS, costs.rows() * costs.cols() - evaluated);
+        return costs;
+    }
+
+    /*
+     * Calculate the topological costs between the graphs with the given node degrees, for alpha = 0,
+     * where the cost only depends on degree and the GDVs are not needed.
+     */
+    CostMatrix degree_dist(const std::vector<unsigned> &g_degs, const std::vector<unsigned> &h_degs, std::string scratch_dir)
+    {
+        // Calculate the highest degree among all the nodes in G, H
+        unsigned g_max_deg = g_degs.empty() ? 0 : *std::max_element(g_degs.begin(), g_degs.end());
+        unsigned h_max_deg = h_degs.empty() ? 0 : *std::max_element(h_degs.begin(), h_degs.end());
+
+        CostMatrix costs(g_degs.size(), h_degs.size(), 0, scratch_dir);
+
+        for (std::size_t t = 0; t < costs.rows(); t += costs.tile_rows())
         {
-            for (unsigned j = 0; j < h_gdvs.size(); ++j)
+            auto end = std::min(costs.rows(), t + costs.tile_rows());
+            for (auto i = t; i < end; ++i)
             {
-                costs[i][j] = cost(g_gdvs[i], h_gdvs[j], g_max_deg, h_max_deg);
+                for (std::size_t j = 0; j < h_degs.size(); ++j)
+                {
+                    // Maximal cost if either node is a loner
+                    costs[i][j] = (g_degs[i] == 0 || h_degs[j] == 0) ? 1 : 1 - node_degs(g_degs[i], h_degs[j], g_max_deg, h_max_deg);
+                }
             }
+            costs.release(t, end);
         }
 
+        Metrics::add(Metrics::COST_PAIRS, costs.rows() * costs.cols());
         return costs;
     }
 }
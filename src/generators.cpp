@@ -0,0 +1,190 @@
+// generators.cpp
+// Seeded Synthetic Networks
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cost_matrix.h"
+#include "graph.h"
+
+namespace Generators
+{
+    /*
+     * A uniform random number in [0, 1). The conversion is done here rather than by a standard
+     * distribution, whose output is not specified, so a seed gives the same networks on every platform.
+     */
+    double uniform(std::mt19937_64 &rng)
+    {
+        return (rng() >> 11) * 0x1.0p-53;
+    }
+
+    /*
+     * The undirected graph on n nodes, labelled v0 .. v(n-1), with the given edges, in the form an
+     * input file would be read into: each edge is listed in both directions.
+     */
+    Graph graph(std::size_t n, const std::set<std::pair<unsigned, unsigned>> &edges)
+    {
+        std::vector<std::vector<unsigned>> adjacency(n);
+        for (auto &edge : edges)
+        {
+            adjacency[edge.first].push_back(edge.second);
+            adjacency[edge.second].push_back(edge.first);
+        }
+
+        Graph graph;
+        graph.offsets.push_back(0);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            graph.labels.push_back(std::string("v").append(std::to_string(i)));
+            std::sort(adjacency[i].begin(), adjacency[i].end());
+            graph.neighbors.insert(graph.neighbors.end(), adjacency[i].begin(), adjacency[i].end());
+            graph.offsets.push_back(graph.neighbors.size());
+        }
+        return graph;
+    }
+
+    /**
+     * An Erdős–Rényi random network, in which each pair of nodes is an edge independently.
+     *
+     * @param n The number of nodes.
+     * @param p The probability of each edge, i.e. the expected density.
+     * @param seed The seed of the random numbers.
+     *
+     * @return The network.
+     *
+     * @throws std::invalid_argument If p is not in range [0, 1].
+     */
+    Graph erdos_renyi(std::size_t n, double p, std::uint64_t seed)
+    {
+        if (p < 0 || p > 1)
+        {
+            throw std::invalid_argument("The edge probability must be in range [0, 1].");
+        }
+
+        std::mt19937_64 rng(seed);
+        std::set<std::pair<unsigned, unsigned>> edges;
+        for (unsigned i = 0; i < n; ++i)
+        {
+            for (unsigned j = i + 1; j < n; ++j)
+            {
+                if (uniform(rng) < p)
+                {
+                    edges.insert({i, j});
+                }
+            }
+        }
+        return graph(n, edges);
+    }
+
+    /**
+     * A Barabási–Albert scale-free network, grown by preferential attachment: starting from m nodes,
+     * each new node is joined to m distinct earlier nodes, chosen with probability proportional to
+     * their degree.
+     *
+     * @param n The number of nodes.
+     * @param m The number of edges of each new node, at least 1 and less than n.
+     * @param seed The seed of the random numbers.
+     *
+     * @return The network.
+     *
+     * @throws std::invalid_argument If m is out of range.
+     */
+    Graph barabasi_albert(std::size_t n, std::size_t m, std::uint64_t seed)
+    {
+        if (m < 1 || m >= n)
+        {
+            throw std::invalid_argument("The edges per node must be at least 1 and less than the number of nodes.");
+        }
+
+        std::mt19937_64 rng(seed);
+        std::set<std::pair<unsigned, unsigned>> edges;
+        std::vector<unsigned> ends; // each node once per edge it has, so a uniform pick is degree-weighted
+        for (unsigned v = m; v < n; ++v)
+        {
+            std::set<unsigned> targets;
+            while (targets.size() < m)
+            {
+                // The first new node has no degrees to weight by, so it joins every starting node
+                targets.insert(ends.empty() ? targets.size() : ends[std::size_t(uniform(rng) * ends.size())]);
+            }
+            for (auto u : targets)
+            {
+                edges.insert({u, v});
+                ends.push_back(u);
+                ends.push_back(v);
+            }
+        }
+        return graph(n, edges);
+    }
+
+    /**
+     * A block-structured (stochastic block model) network: the nodes are split into blocks of nearly
+     * equal size, and each pair of nodes is an edge independently, more likely within a block.
+     *
+     * @param n The number of nodes.
+     * @param k The number of blocks, at least 1.
+     * @param p_in The probability of an edge within a block.
+     * @param p_out The probability of an edge between blocks.
+     * @param seed The seed of the random numbers.
+     *
+     * @return The network.
+     *
+     * @throws std::invalid_argument If k is 0, or a probability is not in range [0, 1].
+     */
+    Graph blocks(std::size_t n, std::size_t k, double p_in, double p_out, std::uint64_t seed)
+    {
+        if (k < 1)
+        {
+            throw std::invalid_argument("There must be at least one block.");
+        }
+        if (p_in < 0 || p_in > 1 || p_out < 0 || p_out > 1)
+        {
+            throw std::invalid_argument("The edge probabilities must be in range [0, 1].");
+        }
+
+        std::mt19937_64 rng(seed);
+        std::set<std::pair<unsigned, unsigned>> edges;
+        for (unsigned i = 0; i < n; ++i)
+        {
+            for (unsigned j = i + 1; j < n; ++j)
+            {
+                auto is_same_block = (i * k / n == j * k / n);
+                if (uniform(rng) < (is_same_block ? p_in : p_out))
+                {
+                    edges.insert({i, j});
+                }
+            }
+        }
+        return graph(n, edges);
+    }
+
+    /**
+     * A cost matrix of independent uniform random values in [0, 1), to stand in for biological data.
+     *
+     * @param rows The number of rows.
+     * @param cols The number of columns.
+     * @param seed The seed of the random numbers.
+     *
+     * @return The matrix.
+     */
+    CostMatrix uniform_costs(std::size_t rows, std::size_t cols, std::uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        CostMatrix costs(rows, cols);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            for (std::size_t j = 0; j < cols; ++j)
+            {
+                costs[i][j] = uniform(rng);
+            }
+        }
+        return costs;
+    }
+}
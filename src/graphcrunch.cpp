@@ -31,10 +31,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <string>
+#include <array>
 #include <assert.h>
 #include <map> /* STL ordered dictionary class */
+#include <new>
+#include <stdexcept>
 #include <vector>
 
+#include "graph.h"
+#include "metrics.h"
+
 namespace GraphCrunch
 {
     // #define PATH_MAX 256 //Oleksii
@@ -105,24 +111,27 @@ namespace GraphCrunch
 
     void die(char *msg)
     {
-        fprintf(stderr, "ERROR: %s\n", msg);
-        exit(1);
+        throw std::runtime_error(msg);
     }
 
-    std::vector<std::vector<unsigned>> count(FILE *f)
+    std::vector<std::vector<unsigned>> count(int V, const std::vector<std::array<int, 2>> &edge_list)
     {
-        int V;
         int E;
-        int E_undir;
+        int E_undir = edge_list.size();
         int i;
         int j;
 
-        fscanf(f, "%d", &V);
-        fscanf(f, "%d", &E_undir);
         E = E_undir * 2;
         V++; // nodes are numbered from 1 to V
 
-        assert(E_undir >= 0);
+        /* validate the edges before anything is allocated for them */
+        for (const auto &edge : edge_list)
+        {
+            if (edge[0] < 0 || edge[1] < 0 || edge[0] >= V || edge[1] >= V)
+            {
+                throw std::invalid_argument("Node numbers must be in range [0, " + std::to_string(V - 1) + "].");
+            }
+        }
 
         struct temp_data **heads = new temp_data *[V]; // Oleksii
         struct temp_data *links = new temp_data[E];    // Oleksii
@@ -144,8 +153,7 @@ namespace GraphCrunch
             adjmat[i] = (char *)calloc(V / 8 + 1, sizeof(char));
             if (!adjmat[i])
             {
-                perror("calloc");
-                exit(1);
+                throw std::bad_alloc();
             }
 
             Connect(i, i); /* optimization hack */
@@ -158,16 +166,8 @@ namespace GraphCrunch
         /* add data to linked list for intermediate storage */
         for (i = 0; i < E_undir; i++)
         {
-            int src = -1;
-            int dst = -1;
-            fscanf(f, "%d %d", &src, &dst);
-            assert(src < V && dst < V);
-
-            if (src < 0 || dst < 0)
-            {
-                fprintf(stderr, "Error: node numbers must be greater than zero.\n");
-                exit(1);
-            }
+            int src = edge_list[i][0];
+            int dst = edge_list[i][1];
 
             if (src == dst)
                 continue; /* ignore self-loops */
@@ -229,8 +229,7 @@ namespace GraphCrunch
             ncount[i] = (int64 *)calloc(V, sizeof(int64));
             if (!ncount[i])
             {
-                perror("calloc");
-                exit(1);
+                throw std::bad_alloc();
             }
         }
 
@@ -529,6 +528,7 @@ namespace GraphCrunch
 
         /* output */
         std::vector<std::vector<unsigned>> gdvs;
+        unsigned long long orbit_totals[6] = {0, 0, 0, 0, 0, 0}; /* by the number of nodes in the graphlet */
 
         for (j = 1; j < V; j++)
         {
@@ -540,9 +540,16 @@ namespace GraphCrunch
             {
                 gdv.push_back((unsigned)ncount[i][j] / overcount[ntype2gtype[i]]);
             }
+            for (i = 0; i < 73; i++)
+            {
+                orbit_totals[i == 0 ? 2 : i < 4 ? 3 : i < 15 ? 4 : 5] += gdv[i];
+            }
             gdvs.push_back(gdv);
         }
 
+        /* each graphlet appears once in the GDV of each of its nodes */
+        Metrics::add(Metrics::GRAPHLETS, orbit_totals[2] / 2 + orbit_totals[3] / 3 + orbit_totals[4] / 4 + orbit_totals[5] / 5);
+
         return gdvs;
     }
 
@@ -553,15 +560,50 @@ namespace GraphCrunch
         FILE *fp = fopen(in_file, "r");
         if (!fp)
         {
-            perror(in_file);
-            exit(1);
+            throw std::runtime_error("Unable to open file " + in_file_str);
         }
 
-        std::vector<std::vector<unsigned>> gdvs = count(fp);
+        int V = 0;
+        int E_undir = 0;
+        auto valid = (fscanf(fp, "%d", &V) == 1 && fscanf(fp, "%d", &E_undir) == 1 && V >= 0 && E_undir >= 0);
+
+        std::vector<std::array<int, 2>> edge_list(valid ? E_undir : 0, {-1, -1});
+        for (auto &edge : edge_list)
+        {
+            valid &= (fscanf(fp, "%d %d", &edge[0], &edge[1]) == 2);
+        }
 
         fclose(fp);
+        if (!valid)
+        {
+            throw std::runtime_error("File " + in_file_str + " is not a valid graphlet input: the node and edge counts, then one pair of nodes per edge.");
+        }
 
-        return gdvs;
+        return count(V, edge_list);
+    }
+
+    /* Count the graphlets of a loaded network, whose edges are the nonzero entries strictly above the
+     * diagonal of its adjacency matrix (the same edges the file form would list, and those Util::degrees
+     * counts), numbered from 1. Self-loops are not graphlet edges, so they are left out here.
+     */
+    std::vector<std::vector<unsigned>> graphcrunch(const Graph &graph)
+    {
+        int V = graph.size();
+
+        std::vector<std::array<int, 2>> edge_list;
+        for (int i = 0; i < V; i++)
+        {
+            for (auto k = graph.offsets[i]; k < graph.offsets[i + 1]; k++)
+            {
+                int j = graph.neighbors[k];
+                if (j > i && j < V)
+                {
+                    edge_list.push_back({i + 1, j + 1});
+                }
+            }
+        }
+
+        return count(V, edge_list);
     }
 
 }
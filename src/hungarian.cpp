@@ -9,44 +9,36 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "assignment.h"
+#include "checkpoint.h"
+#include "cost_matrix.h"
+#include "dispatch.h"
+#include "metrics.h"
+
 namespace Hungarian
 {
-    int prog = 0;                                               // PROGRESS
+    thread_local int prog = 0;                                  // PROGRESS
+    thread_local bool show_progress = true;                     // PROGRESS
     void print_progress(double val)                             // PROGRESS
     {                                                           // PROGRESS
+        if (!show_progress) return;                             // PROGRESS
         std::cout << "\33[2K\r~ " << (val / 0.15) * 100 << "%"; // PROGRESS
     }                                                           // PROGRESS
 
     const int MAX = 1;
 
-    /*
-     * If the matrix is not square, pad it so it is.
-     */
-    void pad_matrix(std::vector<std::vector<double>> &matrix)
-    {
-        unsigned i_size = matrix.size();
-        unsigned j_size = matrix[0].size();
-
-        if (i_size > j_size)
-        {
-            for (auto &vec : matrix)
-            {
-                vec.resize(i_size, MAX);
-            }
-        }
-        else if (i_size < j_size)
-        {
-            while (matrix.size() < j_size)
-            {
-                matrix.push_back(std::vector<double>(j_size, MAX));
-            }
-        }
-    }
-
     /*
      * Clear the temporary vectors.
      */
@@ -78,7 +70,7 @@ namespace Hungarian
     /*
      *
      */
-    void find_a_zero(int &row, int &col, const std::vector<std::vector<double>> &costs,
+    void find_a_zero(int &row, int &col, const CostMatrix &costs,
                      const std::vector<unsigned char> &row_cover, const std::vector<unsigned char> &col_cover)
     {
         unsigned r = 0;
@@ -99,13 +91,13 @@ namespace Hungarian
                     done = true;
                 }
                 ++c;
-                if (c >= costs.size() || done)
+                if (c >= costs.rows() || done)
                 {
                     break;
                 }
             }
             ++r;
-            if (r >= costs.size())
+            if (r >= costs.rows())
             {
                 done = true;
             }
@@ -192,23 +184,71 @@ namespace Hungarian
         }
     }
 
+    /*
+     * The smallest of minval and the n values of row, each offset by its penalty (0, or infinity to skip it).
+     * The minimum is taken in independent lanes so that it vectorizes.
+     */
+    DISPATCH double row_min(const double *row, const double *penalty, unsigned n, double minval)
+    {
+        const unsigned LANES = 8;
+        double lanes[LANES];
+        std::fill(lanes, lanes + LANES, minval);
+
+        unsigned c = 0;
+        for (; c + LANES <= n; c += LANES)
+        {
+            for (unsigned l = 0; l < LANES; ++l)
+            {
+                lanes[l] = std::min(lanes[l], row[c + l] + penalty[c + l]);
+            }
+        }
+        for (; c < n; ++c)
+        {
+            lanes[0] = std::min(lanes[0], row[c] + penalty[c]);
+        }
+
+        return *std::min_element(lanes, lanes + LANES);
+    }
+
+    /*
+     * Lower each of the n column minimums to the value in row, if it is smaller.
+     */
+    DISPATCH void col_mins(double *mins, const double *row, unsigned n)
+    {
+        for (unsigned c = 0; c < n; ++c)
+        {
+            mins[c] = std::min(mins[c], row[c]);
+        }
+    }
+
+    /*
+     * Add add to each of the n values of row, then subtract the value's column offset.
+     */
+    DISPATCH void shift_row(double *row, double add, const double *sub, unsigned n)
+    {
+        for (unsigned c = 0; c < n; ++c)
+        {
+            row[c] = row[c] + add - sub[c];
+        }
+    }
+
     /*
      * Find the smallest uncovered value in the cost matrix.
      */
-    void find_smallest(double &minval, const std::vector<std::vector<double>> &costs,
+    void find_smallest(double &minval, const CostMatrix &costs,
                        const std::vector<unsigned char> &row_cover, const std::vector<unsigned char> &col_cover)
     {
-        for (unsigned r = 0; r < costs.size(); ++r)
+        std::vector<double> penalty(costs.rows());
+        for (unsigned c = 0; c < costs.rows(); ++c)
+        {
+            penalty[c] = (col_cover[c] == 0) ? 0 : std::numeric_limits<double>::infinity();
+        }
+
+        for (unsigned r = 0; r < costs.rows(); ++r)
         {
-            for (unsigned c = 0; c < costs.size(); ++c)
+            if (row_cover[r] == 0)
             {
-                if (row_cover[r] == 0 && col_cover[c] == 0)
-                {
-                    if (minval > costs[r][c])
-                    {
-                        minval = costs[r][c];
-                    }
-                }
+                minval = row_min(costs[r], penalty.data(), costs.rows(), minval);
             }
         }
     }
@@ -218,37 +258,31 @@ namespace Hungarian
     /*
      * Reduce each row/col subtracting the minimum value in each row/col from all elements it.
      */
-    void step1(std::vector<std::vector<double>> &costs, int &step)
+    void step1(CostMatrix &costs, int &step)
     {
+        // Entries are non-negative, so a minimum that is not positive is 0 and subtracting it changes nothing.
+        std::vector<double> none(costs.cols(), 0);
+
         // For each row of the matrix, find the smallest element and subtract it from every element in its row.
-        for (auto &row : costs)
+        for (unsigned r = 0; r < costs.rows(); ++r)
         {
-            auto smallest = *std::min_element(begin(row), end(row));
+            auto smallest = row_min(costs[r], none.data(), costs.cols(), std::numeric_limits<double>::infinity());
             if (smallest > 0)
             {
-                for (auto &n : row)
-                {
-                    n -= smallest;
-                }
+                shift_row(costs[r], -smallest, none.data(), costs.cols());
             }
         }
 
         // For each col of the matrix, find the smallest element and subtract it from every element in its col.
-        for (unsigned j = 0; j < costs.size(); ++j)
+        // Both passes run along the rows, rather than striding down each column.
+        std::vector<double> mins(costs.cols(), MAX);
+        for (unsigned r = 0; r < costs.rows(); ++r)
         {
-            double minval = MAX;
-            for (unsigned i = 0; i < costs.size(); ++i)
-            {
-                minval = std::min(minval, costs[i][j]);
-            }
-
-            if (minval > 0)
-            {
-                for (unsigned i = 0; i < costs.size(); ++i)
-                {
-                    costs[i][j] -= minval;
-                }
-            }
+            col_mins(mins.data(), costs[r], costs.cols());
+        }
+        for (unsigned r = 0; r < costs.rows(); ++r)
+        {
+            shift_row(costs[r], 0, mins.data(), costs.cols());
         }
 
         step = 2;
@@ -266,12 +300,12 @@ namespace Hungarian
      * Before we go on to Step 3, we uncover all rows and columns so that we can use the
      * cover vectors to help us count the number of starred zeros.
      */
-    void step2(const std::vector<std::vector<double>> &costs, std::vector<std::vector<unsigned char>> &mask,
+    void step2(const CostMatrix &costs, std::vector<std::vector<unsigned char>> &mask,
                std::vector<unsigned char> &row_cover, std::vector<unsigned char> &col_cover, int &step)
     {
-        for (unsigned r = 0; r < costs.size(); ++r)
+        for (unsigned r = 0; r < costs.rows(); ++r)
         {
-            for (unsigned c = 0; c < costs.size(); ++c)
+            for (unsigned c = 0; c < costs.rows(); ++c)
             {
                 if (costs[r][c] == 0)
                 {
@@ -332,7 +366,7 @@ namespace Hungarian
     /*
      * Find a noncovered zero and prime it. Save the smallest uncovered value and Go to Step 6.
      */
-    void step4(const std::vector<std::vector<double>> &costs, std::vector<std::vector<unsigned char>> &mask,
+    void step4(const CostMatrix &costs, std::vector<std::vector<unsigned char>> &mask,
                std::vector<unsigned char> &row_cover, std::vector<unsigned char> &col_cover,
                int &path_row_0, int &path_col_0, int &step)
     {
@@ -351,7 +385,7 @@ namespace Hungarian
             }
             else
             {
-                double p = double(prog++) / (costs.size() * costs.size()); // PROGRESS
+                double p = double(prog++) / (costs.rows() * costs.rows()); // PROGRESS
                 print_progress(p);                                         // PROGRESS
 
                 mask[row][col] = 2;
@@ -438,107 +472,225 @@ namespace Hungarian
      * values by an amount equal to the smallest value in the cost matrix, so we will not
      * jump over the optimal (i.e. minimal assignment) with this change.
      */
-    void step6(std::vector<std::vector<double>> &costs, const std::vector<unsigned char> &row_cover,
+    void step6(CostMatrix &costs, const std::vector<unsigned char> &row_cover,
                const std::vector<unsigned char> &col_cover, int &step)
     {
         double minval = MAX;
         find_smallest(minval, costs, row_cover, col_cover);
 
-        for (unsigned r = 0; r < costs.size(); ++r)
+        std::vector<double> sub(costs.rows());
+        for (unsigned c = 0; c < costs.rows(); ++c)
         {
-            for (unsigned c = 0; c < costs.size(); ++c)
-            {
-                if (row_cover[r] == 1)
-                {
-                    costs[r][c] += minval;
-                }
-                if (col_cover[c] == 0)
-                {
-                    costs[r][c] -= minval;
-                }
-            }
+            sub[c] = (col_cover[c] == 0) ? minval : 0;
+        }
+
+        for (unsigned r = 0; r < costs.rows(); ++r)
+        {
+            shift_row(costs[r], (row_cover[r] == 1) ? minval : 0, sub.data(), costs.rows());
         }
 
         step = 4;
     }
 
     /*
-     * Calculates the optimal cost from mask matrix.
+     * Reads the assignment, and the similarity of each aligned pair, from the mask matrix.
      */
-    std::vector<std::vector<double>> output_solution(const std::vector<std::vector<double>> &original,
-                                                     const std::vector<std::vector<unsigned char>> &mask)
+    Assignment output_solution(const CostMatrix &original, const std::vector<std::vector<unsigned char>> &mask)
     {
-        std::vector<std::vector<double>> alignment;
+        Assignment alignment;
+        alignment.rows = original.rows();
+        alignment.cols = original.cols();
+        alignment.match.assign(original.rows(), Assignment::NONE);
+        alignment.similarity.assign(original.rows(), 0);
 
-        for (unsigned r = 0; r < original.size(); ++r)
+        for (unsigned r = 0; r < original.rows(); ++r)
         {
-            std::vector<double> row;
-            for (unsigned c = 0; c < original[r].size(); ++c)
+            for (unsigned c = 0; c < original.cols(); ++c)
             {
                 if (mask[r][c] != 0)
                 {
-                    row.push_back(1 - original[r][c]);
-                }
-                else
-                {
-                    row.push_back(0);
+                    alignment.match[r] = c;
+                    alignment.similarity[r] = 1 - original[r][c];
+                    break;
                 }
             }
-            alignment.push_back(row);
         }
         return alignment;
     }
 
+    const char SNAPSHOT_MAGIC[8] = {'M', 'I', 'N', 'A', 'A', 'H', 'U', 'N'};
+    const std::string SNAPSHOT_NAME = "solver.bin";
+
     /*
-     * Driver code.
+     * The fixed-size header of a snapshot of the solver between steps. It is followed by the reduced cost
+     * matrix (n x n double), the mask (n x n bytes), and the row and column covers (n bytes each), all in
+     * native byte order.
      */
-    std::vector<std::vector<double>> hungarian(std::vector<std::vector<double>> original)
+    struct SnapshotHeader
     {
-        // Validate input values
-        for (auto vec : original)
+        char magic[8];
+        std::uint64_t n;
+        std::int32_t step;
+        std::int32_t path_row_0;
+        std::int32_t path_col_0;
+        std::int32_t reserved;
+        std::uint64_t augmentations;
+    };
+
+    /*
+     * Write the state of the solver between steps to a file.
+     */
+    void save_snapshot(std::string filepath, const CostMatrix &costs, const std::vector<std::vector<unsigned char>> &mask,
+                       const std::vector<unsigned char> &row_cover, const std::vector<unsigned char> &col_cover,
+                       int step, int path_row_0, int path_col_0, unsigned long long augmentations)
+    {
+        SnapshotHeader header;
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.n = costs.rows();
+        header.step = step;
+        header.path_row_0 = path_row_0;
+        header.path_col_0 = path_col_0;
+        header.reserved = 0;
+        header.augmentations = augmentations;
+
+        std::ofstream fout;
+        fout.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+        try
         {
-            for (auto val : vec)
+            fout.open(filepath, std::ios::binary);
+            fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            for (std::size_t r = 0; r < costs.rows(); r += costs.tile_rows())
             {
-                if (val < 0 || val > MAX)
-                {
-                    std::cout << "Error: Input contains invalid values. All entries must be in range [0,1]." << std::endl;
-                    return {};
-                }
+                auto end = std::min(costs.rows(), r + costs.tile_rows());
+                fout.write(reinterpret_cast<const char *>(costs[r]), (end - r) * costs.cols() * sizeof(double));
+            }
+            for (auto &row : mask)
+            {
+                fout.write(reinterpret_cast<const char *>(row.data()), row.size());
             }
+            fout.write(reinterpret_cast<const char *>(row_cover.data()), row_cover.size());
+            fout.write(reinterpret_cast<const char *>(col_cover.data()), col_cover.size());
+            Metrics::add(Metrics::BYTES_WRITTEN, fout.tellp());
+            fout.close();
+        }
+        catch (const std::ofstream::failure &e)
+        {
+            throw std::runtime_error("Unable to write to file " + filepath);
+        }
+    }
+
+    /*
+     * Restore the state of the solver between steps from a file written by save_snapshot, into working
+     * matrices of the same size.
+     */
+    void load_snapshot(std::string filepath, CostMatrix &costs, std::vector<std::vector<unsigned char>> &mask,
+                       std::vector<unsigned char> &row_cover, std::vector<unsigned char> &col_cover,
+                       int &step, int &path_row_0, int &path_col_0, unsigned long long &augmentations)
+    {
+        auto invalid = std::runtime_error("File " + filepath + " is not a valid snapshot of this alignment");
+        std::ifstream fin(filepath, std::ios::binary);
+        SnapshotHeader header;
+        if (!fin.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header.n != costs.rows() ||
+            header.step < 2 || header.step > 6)
+        {
+            throw invalid;
         }
 
-        // Duplicate original matrix
-        std::vector<std::vector<double>> costs(original.size(), std::vector<double>(original.begin()->size()));
-        auto it = original.begin();
-        for (auto &vec : costs)
+        for (std::size_t r = 0; r < costs.rows(); r += costs.tile_rows())
+        {
+            auto end = std::min(costs.rows(), r + costs.tile_rows());
+            fin.read(reinterpret_cast<char *>(costs[r]), (end - r) * costs.cols() * sizeof(double));
+        }
+        for (auto &row : mask)
+        {
+            fin.read(reinterpret_cast<char *>(row.data()), row.size());
+        }
+        fin.read(reinterpret_cast<char *>(row_cover.data()), row_cover.size());
+        fin.read(reinterpret_cast<char *>(col_cover.data()), col_cover.size());
+        if (!fin)
         {
-            std::copy(it->begin(), it->end(), vec.begin());
-            it = std::next(it);
+            throw invalid;
         }
+        Metrics::add(Metrics::BYTES_READ, fin.tellg());
 
-        // Make the matrix square
-        pad_matrix(costs);
+        step = header.step;
+        path_row_0 = header.path_row_0;
+        path_col_0 = header.path_col_0;
+        augmentations = header.augmentations;
+    }
+
+    /*
+     * Driver code.
+     * Working matrices are stored out of core in scratch_dir, if one is given.
+     * Progress is printed to std::cout if show is set.
+     * A pair whose cost is NaN was pruned before it was evaluated, and is solved as if at the maximal cost.
+     * With a checkpoint, the solver's state is saved there periodically, and restored from there if saved.
+     */
+    Assignment hungarian(const CostMatrix &original, std::string scratch_dir, bool show, const Checkpoint *checkpoint)
+    {
+        prog = 0;             // PROGRESS
+        show_progress = show; // PROGRESS
+
+        CostMatrix costs(std::max(original.rows(), original.cols()), std::max(original.rows(), original.cols()), MAX, scratch_dir);
 
         // mask(i,j)=1 -> C(i,j) is a starred zero, mask(i,j)=2 -> C(i,j) is a primed zero
-        std::vector<std::vector<unsigned char>> mask(costs.size(), std::vector<unsigned char>(costs.size(), 0));
+        std::vector<std::vector<unsigned char>> mask(costs.rows(), std::vector<unsigned char>(costs.rows(), 0));
 
         /* We also define two vectors row_cover and col_cover that are used to "cover"
          * the rows and columns of the cost matrix C
          */
-        std::vector<unsigned char> row_cover(costs.size(), 0);
-        std::vector<unsigned char> col_cover(costs.size(), 0);
+        std::vector<unsigned char> row_cover(costs.rows(), 0);
+        std::vector<unsigned char> col_cover(costs.rows(), 0);
 
-        int path_row_0; // temporary to hold the smallest uncovered value
-        int path_col_0;
+        int path_row_0 = 0; // temporary to hold the smallest uncovered value
+        int path_col_0 = 0;
 
         // Array for the augmenting path algorithm
-        std::vector<std::vector<int>> path(costs.size() + 1, std::vector<int>(2, 0));
+        std::vector<std::vector<int>> path(costs.rows() + 1, std::vector<int>(2, 0));
 
         bool done = false;
         int step = 1;
+        unsigned long long augmentations = 0;
+
+        if (checkpoint != nullptr && checkpoint->has(SNAPSHOT_NAME))
+        {
+            // Continue from the last snapshot, whose input was validated when it was first copied
+            load_snapshot(checkpoint->path(SNAPSHOT_NAME), costs, mask, row_cover, col_cover, step, path_row_0, path_col_0, augmentations);
+        }
+        else
+        {
+            // Duplicate original matrix into a square matrix, padded with the maximal cost, which pruned
+            // pairs are given too, validating the values as they are copied
+            for (unsigned r = 0; r < original.rows(); ++r)
+            {
+                auto valid = true;
+                for (unsigned c = 0; c < original.cols(); ++c)
+                {
+                    costs[r][c] = std::isnan(original[r][c]) ? MAX : original[r][c];
+                    valid &= (costs[r][c] >= 0 && costs[r][c] <= MAX);
+                }
+                if (!valid)
+                {
+                    throw std::runtime_error("Input contains invalid values. All entries must be in range [0,1].");
+                }
+            }
+        }
 
+        auto last_snapshot = std::chrono::steady_clock::now();
         while (!done)
         {
+            // The state is whole between steps, so snapshot it there once the interval has passed
+            if (checkpoint != nullptr && step >= 2 && step <= 6 &&
+                std::chrono::steady_clock::now() - last_snapshot >= std::chrono::seconds(checkpoint->interval_s()))
+            {
+                checkpoint->save(SNAPSHOT_NAME, [&](std::string filepath)
+                {
+                    save_snapshot(filepath, costs, mask, row_cover, col_cover, step, path_row_0, path_col_0, augmentations);
+                });
+                last_snapshot = std::chrono::steady_clock::now();
+            }
+
             switch (step)
             {
             case 1:
@@ -554,6 +706,7 @@ namespace Hungarian
                 step4(costs, mask, row_cover, col_cover, path_row_0, path_col_0, step);
                 break;
             case 5:
+                ++augmentations;
                 step5(path, path_row_0, path_col_0, mask, row_cover, col_cover, step);
                 break;
             case 6:
@@ -562,9 +715,9 @@ namespace Hungarian
             case 7:
                 for (auto &vec : mask)
                 {
-                    vec.resize(original.begin()->size());
+                    vec.resize(original.cols());
                 }
-                mask.resize(original.size());
+                mask.resize(original.rows());
                 done = true;
                 break;
             default:
@@ -573,6 +726,7 @@ namespace Hungarian
             }
         }
 
+        Metrics::add(Metrics::AUGMENTATIONS, augmentations);
         return output_solution(original, mask);
     }
 
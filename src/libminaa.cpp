@@ -0,0 +1,197 @@
+// libminaa.cpp
+// Alignment of Networks Held in Memory
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "assignment.h"
+#include "candidates.h"
+#include "checkpoint.h"
+#include "cost_matrix.h"
+#include "graph.h"
+#include "libminaa.h"
+#include "hungarian.h"
+#include "gdvs_dist.h"
+#include "graphcrunch.h"
+#include "util.h"
+
+namespace MiNAA
+{
+    /*
+     * Copy a viewed network into a graph, with its nodes left unlabelled, validating its structure.
+     */
+    Graph graph(GraphView view, std::string name)
+    {
+        if (view.size > 0 && (view.offsets == nullptr || (view.offsets[view.size] > 0 && view.neighbors == nullptr)))
+        {
+            throw std::invalid_argument("The network " + name + " must have offsets and neighbors.");
+        }
+
+        Graph graph;
+        graph.labels.resize(view.size);
+        if (view.size > 0)
+        {
+            graph.offsets.assign(view.offsets, view.offsets + view.size + 1);
+            graph.neighbors.assign(view.neighbors, view.neighbors + view.offsets[view.size]);
+        }
+        else
+        {
+            graph.offsets.assign(1, 0);
+        }
+        for (std::size_t i = 0; i < view.size; ++i)
+        {
+            if (graph.offsets[i] > graph.offsets[i + 1])
+            {
+                throw std::invalid_argument("The offsets of network " + name + " must not decrease.");
+            }
+        }
+        if (std::any_of(graph.neighbors.begin(), graph.neighbors.end(), [&](unsigned j) { return j >= view.size; }))
+        {
+            throw std::invalid_argument("The neighbors of network " + name + " must be nodes of it.");
+        }
+
+        return graph;
+    }
+
+    /**
+     * Plan which stages of an alignment the options make relevant.
+     *
+     * @param options How to align the networks.
+     * @param do_bio Whether a biological matrix is combined with the topological costs.
+     *
+     * @return The stages to run, and the cutoff to abandon the topological costs of pairs at.
+     */
+    Stages stages(Options options, bool do_bio)
+    {
+        Stages stages;
+        stages.do_topology = !(do_bio && options.beta == 0);
+        stages.do_graphlets = stages.do_topology && options.alpha != 0;
+
+        // A pair is reported only if its overall cost is below 1 - threshold, and its overall cost is at
+        // least beta times its topological cost, so a pair whose topological cost exceeds
+        // (1 - threshold) / beta can never be reported. Pruning it changes the costs the solver sees,
+        // so it is only done when asked for
+        if (stages.do_graphlets && options.do_prune)
+        {
+            auto reportable = 1 - options.similarity_threshold;
+            stages.cutoff = std::min(1.0, do_bio ? reportable / options.beta : reportable);
+        }
+        return stages;
+    }
+
+    /**
+     * Calculate the topological cost matrix of G and H: from their GDVs, abandoning pairs at the cutoff,
+     * or from their node degrees alone if the graphlets are not relevant.
+     *
+     * @param stages The stages of the alignment, which must include the topology.
+     * @param alpha The GDV - edge weight balancer.
+     * @param g The graph of G.
+     * @param h The graph of H.
+     * @param g_gdvs The GDVs of G, if the graphlets are relevant.
+     * @param h_gdvs The GDVs of H, if the graphlets are relevant.
+     * @param scratch_dir If nonempty, the directory in which to store the matrix out of core.
+     *
+     * @return The topological cost matrix.
+     */
+    CostMatrix topological_costs(const Stages &stages, double alpha, const Graph &g, const Graph &h,
+                                 const std::vector<std::vector<unsigned>> &g_gdvs, const std::vector<std::vector<unsigned>> &h_gdvs, std::string scratch_dir)
+    {
+        if (stages.do_graphlets)
+        {
+            return GDVs_Dist::gdvs_dist(g_gdvs, h_gdvs, alpha, stages.cutoff, scratch_dir);
+        }
+        return GDVs_Dist::degree_dist(Util::degrees(g), Util::degrees(h), scratch_dir);
+    }
+
+    /**
+     * Align network G to network H, in memory, planning the stages and calculating the topological costs
+     * as for an alignment of files. Nothing is read, written or printed.
+     *
+     * @param g The network G.
+     * @param h The network H.
+     * @param bio The biological matrix, or none to align by topology alone.
+     * @param options How to align the networks.
+     *
+     * @return The alignment of G to H, the cost matrix it was found by, and the GDVs if asked for.
+     *
+     * @throws std::invalid_argument If a network or the biological matrix is malformed, or an option is
+     * out of range.
+     * @throws std::runtime_error If the biological matrix contains values that cannot be normalized.
+     */
+    Result align(GraphView g, GraphView h, std::optional<CostView> bio, Options options)
+    {
+        auto alpha = options.alpha;
+        auto beta = options.beta;
+        if (alpha < 0 || alpha > 1)
+        {
+            throw std::invalid_argument("The alpha option must be in range [0, 1].");
+        }
+        if (beta < 0 || beta > 1)
+        {
+            throw std::invalid_argument("The beta option must be in range [0, 1].");
+        }
+        if (options.similarity_threshold < 0 || options.similarity_threshold > 1)
+        {
+            throw std::invalid_argument("The similarity threshold option must be in range [0, 1].");
+        }
+        if (bio && (bio->rows != g.size || bio->cols != h.size || (bio->rows * bio->cols > 0 && bio->values == nullptr)))
+        {
+            throw std::invalid_argument("The biological matrix must have a row for each node of G and a column for each node of H.");
+        }
+
+        auto g_graph = graph(g, "G");
+        auto h_graph = graph(h, "H");
+
+        // Plan which stages the parameters make relevant, as for files
+        auto do_bio = bio.has_value();
+        auto relevant = stages(options, do_bio);
+
+        Result result;
+        CostMatrix topological_costs;
+        if (relevant.do_graphlets)
+        {
+            result.g_gdvs = GraphCrunch::graphcrunch(g_graph);
+            result.h_gdvs = GraphCrunch::graphcrunch(h_graph);
+        }
+        if (relevant.do_topology)
+        {
+            topological_costs = MiNAA::topological_costs(relevant, alpha, g_graph, h_graph, result.g_gdvs, result.h_gdvs, "");
+        }
+
+        if (do_bio)
+        {
+            // Copy the biological matrix, to combine in place of it, normalizing it as it is combined
+            result.costs = CostMatrix(bio->rows, bio->cols);
+            for (std::size_t r = 0; r < bio->rows; ++r)
+            {
+                std::copy(bio->values + r * bio->cols, bio->values + (r + 1) * bio->cols, result.costs[r]);
+            }
+            if (relevant.do_topology)
+            {
+                Util::combine(topological_costs, result.costs, beta, true, bio->is_similarity);
+            }
+            else
+            {
+                Util::normalize(result.costs, bio->is_similarity);
+            }
+        }
+        else
+        {
+            result.costs = std::move(topological_costs);
+        }
+
+        result.alignment = Hungarian::hungarian(result.costs, "", false);
+        if (!options.do_gdvs)
+        {
+            result.g_gdvs.clear();
+            result.h_gdvs.clear();
+        }
+        return result;
+    }
+}
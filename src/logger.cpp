@@ -0,0 +1,107 @@
+// logger.cpp
+// Buffered Run Log
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "logger.h"
+
+Logger::Logger() : level_(INFO), quiet_(false)
+{
+}
+
+Logger::~Logger()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        // Nothing more can be reported while shutting down
+    }
+}
+
+/**
+ * Start writing the log to the given file, beginning with everything logged so far.
+ *
+ * @param filepath The path to the log file, which is appended to.
+ *
+ * @throws std::runtime_error If the file could not be opened.
+ */
+void Logger::open(std::string filepath)
+{
+    file_.open(filepath, std::ios_base::app);
+    if (!file_.good())
+    {
+        throw std::runtime_error("Unable to write to file " + filepath);
+    }
+    flush();
+}
+
+/**
+ * Log the given string, and echo it to std::cout unless quiet.
+ * Messages below the logger's level are dropped. A message that ends a line flushes the log.
+ *
+ * @param str The string to log.
+ * @param level The importance of the message.
+ *
+ * @throws std::runtime_error If the log file could not be written.
+ */
+void Logger::out(std::string str, Level level)
+{
+    if (level < level_)
+    {
+        return;
+    }
+
+    buffer_ += str;
+    if (!quiet_)
+    {
+        std::cout << str;
+    }
+    if (!str.empty() && str.back() == '\n')
+    {
+        flush();
+    }
+}
+
+/**
+ * Log the given error, and echo it to std::cerr even when quiet. Flushes the log.
+ *
+ * @param str The description of the error.
+ *
+ * @throws std::runtime_error If the log file could not be written.
+ */
+void Logger::err(std::string str)
+{
+    std::string err_str = "\nERROR:\n " + str + "\nPROGRAM TERMINATING\n";
+
+    std::cout << std::flush;
+    std::cerr << err_str << std::flush;
+    buffer_ += err_str;
+    flush();
+}
+
+/**
+ * Write everything logged so far to the log file, if it is open, and to the console.
+ *
+ * @throws std::runtime_error If the log file could not be written.
+ */
+void Logger::flush()
+{
+    std::cout << std::flush;
+    if (!file_.is_open())
+    {
+        return;
+    }
+
+    file_ << buffer_ << std::flush;
+    buffer_.clear();
+    if (!file_.good())
+    {
+        throw std::runtime_error("Unable to write to the log file");
+    }
+}
@@ -0,0 +1,199 @@
+// metrics.cpp
+// Stage Timers, Work Counters and Peak Memory
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "metrics.h"
+
+namespace
+{
+    thread_local Metrics *current_metrics = nullptr;
+
+    const char *COUNTER_NAMES[Metrics::COUNTERS] = {"graphlets", "cost_pairs", "pruned_pairs", "augmentations", "bytes_read", "bytes_written"};
+
+    /*
+     * The most memory the process has had resident at once so far, in bytes, or 0 if unknown.
+     */
+    std::size_t peak_rss()
+    {
+        #ifndef _WIN32 // Unix
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+        {
+            #ifdef __APPLE__
+            return usage.ru_maxrss; // in bytes
+            #else
+            return static_cast<std::size_t>(usage.ru_maxrss) * 1024; // in kilobytes
+            #endif
+        }
+        #endif
+        return 0;
+    }
+
+    /*
+     * The given string as a JSON string literal.
+     */
+    std::string quote(std::string str)
+    {
+        std::string quoted = "\"";
+        for (auto c : str)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+}
+
+/**
+ * Make the given metrics current on this thread, until the scope ends.
+ *
+ * @param metrics The metrics, or nullptr to count nothing.
+ */
+Metrics::Scope::Scope(Metrics *metrics) : previous_(current_metrics)
+{
+    current_metrics = metrics;
+}
+
+Metrics::Scope::~Scope()
+{
+    current_metrics = previous_;
+}
+
+/**
+ * Start timing a stage.
+ *
+ * @param metrics The metrics to record the stage in.
+ * @param stage The name of the stage.
+ */
+Metrics::Timer::Timer(Metrics &metrics, std::string stage)
+    : metrics_(metrics), stage_(std::move(stage)), start_(std::chrono::steady_clock::now()), is_stopped_(false)
+{
+}
+
+/*
+ * Record the stage, if it was not stopped already.
+ */
+Metrics::Timer::~Timer()
+{
+    stop();
+}
+
+/**
+ * Stop timing the stage, and record it. Only the first stop records the stage.
+ *
+ * @return The time the stage took, in milliseconds.
+ */
+long long Metrics::Timer::stop()
+{
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+    if (!is_stopped_)
+    {
+        metrics_.record(stage_, ms);
+        is_stopped_ = true;
+    }
+    return ms;
+}
+
+/*
+ * Start measuring, with no stages recorded and every counter at zero.
+ */
+Metrics::Metrics() : start_(std::chrono::steady_clock::now())
+{
+    for (auto &counter : counters_)
+    {
+        counter = 0;
+    }
+}
+
+/**
+ * The metrics current on this thread.
+ *
+ * @return The metrics, or nullptr if there are none.
+ */
+Metrics *Metrics::current()
+{
+    return current_metrics;
+}
+
+/**
+ * Add to a counter of the metrics current on this thread, if there are any.
+ *
+ * @param counter The counter.
+ * @param n The amount of work done.
+ */
+void Metrics::add(Counter counter, unsigned long long n)
+{
+    if (current_metrics != nullptr)
+    {
+        current_metrics->counters_[counter] += n;
+    }
+}
+
+/**
+ * Record a stage, with the peak resident memory of the whole process so far. That is not the memory of
+ * the stage alone: it includes every earlier stage, and any alignment running alongside.
+ *
+ * @param stage The name of the stage.
+ * @param ms The time the stage took, in milliseconds.
+ */
+void Metrics::record(std::string stage, long long ms)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.push_back({std::move(stage), ms, peak_rss()});
+}
+
+/**
+ * The time since measuring started.
+ *
+ * @return The time in milliseconds.
+ */
+long long Metrics::elapsed_ms() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+/**
+ * The metrics as a JSON object: the total time and peak resident memory, the stages in the order they
+ * were recorded, and the counters.
+ *
+ * @return The JSON text.
+ */
+std::string Metrics::to_json() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"total_ms\": " << elapsed_ms() << ",\n";
+    json << "  \"process_peak_rss_bytes\": " << peak_rss() << ",\n";
+    json << "  \"stages\": [";
+    for (std::size_t i = 0; i < stages_.size(); ++i)
+    {
+        json << (i == 0 ? "\n" : ",\n");
+        json << "    {\"name\": " << quote(stages_[i].name) << ", \"ms\": " << stages_[i].ms
+             << ", \"process_peak_rss_bytes_at_end\": " << stages_[i].process_peak_rss << "}";
+    }
+    json << (stages_.empty() ? "],\n" : "\n  ],\n");
+    json << "  \"counters\": {";
+    for (std::size_t c = 0; c < COUNTERS; ++c)
+    {
+        json << (c == 0 ? "\n" : ",\n");
+        json << "    " << quote(COUNTER_NAMES[c]) << ": " << counters_[c];
+    }
+    json << "\n  }\n";
+    json << "}\n";
+    return json.str();
+}
@@ -0,0 +1,90 @@
+// network_cache.cpp
+// Networks Kept Between Alignments
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "assignment.h"
+#include "logger.h"
+#include "network.h"
+#include "network_cache.h"
+#include "settings.h"
+#include "pipeline.h"
+
+/**
+ * An empty cache.
+ *
+ * @param capacity The most networks to keep, at least 1.
+ */
+NetworkCache::NetworkCache(std::size_t capacity) : capacity_(std::max<std::size_t>(1, capacity))
+{
+}
+
+/**
+ * The network of the given file, read, and with its GDVs counted if asked for, reusing the cached
+ * network if the file has not changed since it was cached.
+ *
+ * @param filepath The file the graph is read from.
+ * @param alias The name of the network in outputs, or empty to name it after the file.
+ * @param do_count Whether the GDVs are needed.
+ *
+ * @return A copy of the network, for the caller alone.
+ *
+ * @throws std::runtime_error If the file could not be read.
+ */
+Network NetworkCache::get(std::string filepath, std::string alias, bool do_count)
+{
+    // A file is identified by its absolute path, and changed if its time or size has
+    std::error_code error;
+    auto path = std::filesystem::weakly_canonical(std::filesystem::absolute(filepath), error).string();
+    auto time = std::filesystem::last_write_time(filepath, error).time_since_epoch().count();
+    auto size = std::filesystem::file_size(filepath, error);
+    auto key = path + '\n' + std::to_string(time) + '\n' + std::to_string(size);
+
+    auto cached = entry(key, filepath);
+    std::lock_guard<std::mutex> lock(cached->mutex);
+    Pipeline::load(cached->network);
+    if (do_count)
+    {
+        Pipeline::count(cached->network);
+    }
+
+    auto network = cached->network;
+    network.name = Pipeline::network(filepath, alias).name;
+    return network;
+}
+
+/*
+ * The cache entry of the given key, made (not yet read) if it is not cached, and marked most recently
+ * used. Least recently used entries are dropped once there are too many; they stay alive until the
+ * alignments using them let go.
+ */
+std::shared_ptr<NetworkCache::Entry> NetworkCache::entry(std::string key, std::string filepath)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = entries_.find(key);
+    if (found != entries_.end())
+    {
+        order_.splice(order_.begin(), order_, found->second.second);
+        return found->second.first;
+    }
+
+    auto cached = std::make_shared<Entry>();
+    cached->network = Pipeline::network(filepath, "");
+    order_.push_front(key);
+    entries_.emplace(key, std::make_pair(cached, order_.begin()));
+    while (entries_.size() > capacity_)
+    {
+        entries_.erase(order_.back());
+        order_.pop_back();
+    }
+    return cached;
+}
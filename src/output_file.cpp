@@ -0,0 +1,173 @@
+// output_file.cpp
+// Plain and Gzip-Compressed Text Output
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "metrics.h"
+#include "output_file.h"
+
+namespace
+{
+    const std::size_t CHUNK = 1 << 18; // bytes compressed at once
+}
+
+/*
+ * A stream buffer that deflates everything written to it into a gzip stream, written to the given sink.
+ */
+class OutputFile::GzipBuffer : public std::streambuf
+{
+public:
+    explicit GzipBuffer(std::filebuf &sink) : sink_(sink), in_(CHUNK), out_(CHUNK), zs_()
+    {
+        // 15 + 16: the largest window, with a gzip rather than a zlib wrapper
+        if (deflateInit2(&zs_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            throw std::bad_alloc();
+        }
+        setp(in_.data(), in_.data() + in_.size());
+    }
+
+    ~GzipBuffer()
+    {
+        deflateEnd(&zs_);
+    }
+
+    /*
+     * Compress whatever is buffered and end the gzip stream.
+     */
+    bool finish()
+    {
+        return deflate_buffer(Z_FINISH);
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!deflate_buffer(Z_NO_FLUSH))
+        {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        return deflate_buffer(Z_NO_FLUSH) ? 0 : -1;
+    }
+
+private:
+    std::filebuf &sink_;
+    std::vector<char> in_;
+    std::vector<char> out_;
+    z_stream zs_;
+
+    /*
+     * Feed the buffered input to deflate, writing out the compressed output as it is produced.
+     */
+    bool deflate_buffer(int flush)
+    {
+        zs_.next_in = reinterpret_cast<Bytef *>(pbase());
+        zs_.avail_in = pptr() - pbase();
+        int rc;
+        do
+        {
+            zs_.next_out = reinterpret_cast<Bytef *>(out_.data());
+            zs_.avail_out = out_.size();
+            rc = deflate(&zs_, flush);
+            if (rc == Z_STREAM_ERROR)
+            {
+                return false;
+            }
+            std::streamsize have = out_.size() - zs_.avail_out;
+            if (have > 0 && sink_.sputn(out_.data(), have) != have)
+            {
+                return false;
+            }
+        } while (zs_.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+        setp(in_.data(), in_.data() + in_.size());
+        return true;
+    }
+};
+
+/**
+ * Create the file at the given path, gzip-compressed if the path ends in .gz.
+ *
+ * @param filepath The path to the file to create.
+ *
+ * @throws std::runtime_error If the file could not be created.
+ */
+OutputFile::OutputFile(std::string filepath) : std::ostream(nullptr), filepath_(filepath)
+{
+    auto is_gzip = filepath.size() > 3 && filepath.compare(filepath.size() - 3, 3, ".gz") == 0;
+    if (file_.open(filepath, is_gzip ? std::ios::out | std::ios::binary : std::ios::out) == nullptr)
+    {
+        throw std::runtime_error("Unable to open file " + filepath);
+    }
+    if (is_gzip)
+    {
+        gzip_ = std::make_unique<GzipBuffer>(file_);
+        rdbuf(gzip_.get());
+    }
+    else
+    {
+        rdbuf(&file_);
+    }
+    exceptions(std::ostream::badbit);
+}
+
+OutputFile::~OutputFile()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+        // Errors are only reported by an explicit close
+    }
+}
+
+/**
+ * Finish writing the file, ending the gzip stream if it is compressed.
+ *
+ * @throws std::runtime_error If the file could not be written.
+ */
+void OutputFile::close()
+{
+    if (!file_.is_open())
+    {
+        return;
+    }
+
+    auto ok = good();
+    if (gzip_)
+    {
+        ok = gzip_->finish() && ok;
+    }
+    ok = (file_.close() != nullptr) && ok;
+    if (!ok)
+    {
+        throw std::runtime_error("Unable to write to file " + filepath_);
+    }
+
+    std::error_code error;
+    auto size = std::filesystem::file_size(filepath_, error);
+    if (!error)
+    {
+        Metrics::add(Metrics::BYTES_WRITTEN, size);
+    }
+}
@@ -0,0 +1,1090 @@
+// pipeline.cpp
+// Alignment of a Pair of Networks
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "assignment.h"
+#include "async_writer.h"
+#include "candidates.h"
+#include "checkpoint.h"
+#include "cost_matrix.h"
+#include "graph.h"
+#include "libminaa.h"
+#include "logger.h"
+#include "metrics.h"
+#include "task_graph.h"
+#include "network.h"
+#include "settings.h"
+#include "hungarian.h"
+#include "graphcrunch.h"
+#include "file_io.h"
+#include "util.h"
+
+namespace Pipeline
+{
+    const auto LOG_FILENAME = "log.txt";
+    const auto TOP_COSTS_FILENAME = "topological_costs.csv";
+    const auto BIO_COSTS_FILENAME = "biological_costs.csv";
+    const auto OVERALL_COSTS_FILENAME = "overall_costs.csv";
+    const auto TOP_COSTS_NPY_FILENAME = "topological_costs.npy";
+    const auto BIO_COSTS_NPY_FILENAME = "biological_costs.npy";
+    const auto OVERALL_COSTS_NPY_FILENAME = "overall_costs.npy";
+    const auto ALIGNMENT_MATRIX_FILENAME = "alignment_matrix.csv";
+    const auto ALIGNMENT_LIST_FILENAME = "alignment_list.csv";
+    const auto CANDIDATES_FILENAME = "candidates.csv";
+    const auto METRICS_FILENAME = "metrics.json";
+    const auto SUMMARY_FILENAME = "summary.csv";
+    const auto SWEEP_SUMMARY_FILENAME = "sweep_summary.csv";
+    const auto CHECKPOINT_DIRNAME = "checkpoint/";
+    const auto GRAPH_CHECKPOINT_SUFFIX = ".csr";
+    const auto GDVS_CHECKPOINT_SUFFIX = "_gdvs.npy";
+
+    /**
+     * Read the network's graph, if it has not been read yet.
+     *
+     * @param network The network.
+     *
+     * @throws std::runtime_error If the graph could not be read.
+     */
+    void load(Network &network)
+    {
+        if (!network.is_loaded)
+        {
+            network.graph = FileIO::file_to_graph(network.file, false);
+            network.is_loaded = true;
+        }
+    }
+
+    /**
+     * Count the GDVs of the network's graph, if they have not been counted yet. The graph must be read.
+     *
+     * @param network The network.
+     */
+    void count(Network &network)
+    {
+        if (!network.is_counted)
+        {
+            network.gdvs = GraphCrunch::graphcrunch(network.graph);
+            network.is_counted = true;
+        }
+    }
+
+    /*
+     * The cost matrices of a pair of networks that later alignments of the same pair can reuse, when
+     * only alpha or beta changes between them: the topological costs depend only on alpha and the cutoff
+     * they were pruned at, and the normalized biological costs on neither.
+     */
+    struct Intermediates
+    {
+        bool is_kept = false; // whether to keep the biological costs for later alignments
+        double alpha = std::numeric_limits<double>::quiet_NaN(); // the alpha of the topological costs
+        double cutoff = std::numeric_limits<double>::quiet_NaN(); // the cutoff they were pruned at
+        CostMatrix topological_costs;
+        CostMatrix biological_costs; // normalized, and converted to costs
+    };
+
+    /**
+     * The settings given by parsed command line arguments.
+     *
+     * @param args The arguments, as returned by Util::parse_args.
+     * @param command The command line, as logged.
+     *
+     * @return The settings, timestamped now.
+     */
+    Settings settings(const std::vector<std::string> &args, std::string command)
+    {
+        Settings settings;
+        settings.command = command;
+        settings.datetime = Util::now();
+        settings.bio_file = args[3];
+        settings.bio_alias = args[9];
+        settings.alpha = std::stod(args[4]);
+        settings.beta = std::stod(args[5]);
+        settings.similarity_threshold = std::stod(args[6]);
+        settings.alpha_stamp = args[4];
+        settings.beta_stamp = args[5];
+        settings.do_passthrough = (args[10] == "1");
+        settings.do_timestamp = (args[11] == "1");
+        settings.do_greekstamp = (args[12] == "1");
+        settings.do_similarity_conversion = (args[13] == "1");
+        settings.scratch_dir = args[14];
+        settings.do_binary_graphs = (args[15] == "1");
+        settings.do_npy = (args[16] == "1");
+        settings.is_quiet = (args[17] == "1");
+        settings.is_verbose = (args[18] == "1");
+        settings.do_compress = (args[19] == "1");
+        settings.top_k = std::stoul(args[20]);
+        settings.mem_limit = std::stoull(args[21]);
+        settings.checkpoint_s = std::stoul(args[22]);
+        settings.do_resume = (args[23] == "1");
+        settings.do_prune = (args[24] == "1");
+        return settings;
+    }
+
+    /*
+     * The options of the settings that choose and shape the stages of an alignment, as the library takes them.
+     */
+    MiNAA::Options options(const Settings &settings)
+    {
+        MiNAA::Options options;
+        options.alpha = settings.alpha;
+        options.beta = settings.beta;
+        options.similarity_threshold = settings.similarity_threshold;
+        options.do_prune = settings.do_prune;
+        return options;
+    }
+
+    /**
+     * A network to align, to be read from the given file when first needed.
+     *
+     * @param filepath The file the graph is read from.
+     * @param alias The name of the network in outputs, or empty to name it after the file.
+     *
+     * @return The network, not yet read.
+     */
+    Network network(std::string filepath, std::string alias)
+    {
+        Network network;
+        network.file = filepath;
+        network.name = FileIO::name_file(filepath, alias);
+        return network;
+    }
+
+    /**
+     * The network files to align to, given either a directory of them or a list file with one path per
+     * line. Hidden files in a directory, and blank lines and lines starting with # in a list, are skipped.
+     * Relative paths in a list are taken relative to the list file.
+     *
+     * @param path The directory or list file.
+     *
+     * @return The network files, in sorted order for a directory, or in listed order for a list.
+     *
+     * @throws std::runtime_error If the directory or list could not be read, or names no files.
+     */
+    std::vector<std::string> network_files(std::string path)
+    {
+        std::vector<std::string> files;
+        if (FileIO::is_directory(path))
+        {
+            for (const auto &entry : std::filesystem::directory_iterator(path))
+            {
+                auto name = entry.path().filename().string();
+                if (entry.is_regular_file() && !name.empty() && name[0] != '.')
+                {
+                    files.push_back(entry.path().string());
+                }
+            }
+            std::sort(files.begin(), files.end());
+        }
+        else
+        {
+            std::ifstream fin(path);
+            if (!fin.good())
+            {
+                throw std::runtime_error("Unable to open file " + path);
+            }
+            auto base = std::filesystem::path(path).parent_path();
+            std::string line;
+            while (std::getline(fin, line))
+            {
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                line.erase(0, line.find_first_not_of(" \t"));
+                if (line.empty() || line[0] == '#')
+                {
+                    continue;
+                }
+                std::filesystem::path file(line);
+                files.push_back((file.is_relative() ? base / file : file).string());
+            }
+        }
+
+        if (files.empty())
+        {
+            throw std::runtime_error("No network files in " + path);
+        }
+        return files;
+    }
+
+    /*
+     * The peak memory, in bytes, that aligning G to H is expected to take, with the GDVs that are already
+     * counted. The graphs are held throughout; on top of them, the larger of two phases: building the cost
+     * matrices, while GraphCrunch's bitsets, orbit counts and edge lists overlap parsing the biological
+     * file, then solving, with the matrix aligned by (and the others, if kept) beside the solver's square
+     * working matrix and mask. A matrix stored out of core only counts the tile it is written through.
+     */
+    std::size_t memory_estimate(const Settings &settings, const Network &g, const Network &h, bool is_kept)
+    {
+        const std::size_t TILE_BYTES = std::size_t(64) << 20;
+        std::size_t pairs = g.graph.size() * h.graph.size();
+        std::size_t n = std::max(g.graph.size(), h.graph.size());
+        auto do_bio = (settings.bio_file != "");
+        auto relevant = MiNAA::stages(options(settings), do_bio);
+        auto do_topology = relevant.do_topology;
+        auto do_graphlets = relevant.do_graphlets;
+        auto is_mapped = (settings.scratch_dir != "");
+        auto is_streamed = do_bio && is_mapped && do_topology && !settings.do_passthrough && !is_kept;
+        auto matrix = [&](std::size_t bytes) { return is_mapped ? std::min(bytes, TILE_BYTES) : bytes; };
+
+        std::size_t graphs = 0, counting = 0, gdvs = 0;
+        for (const auto *network : {&g, &h})
+        {
+            std::size_t v = network->graph.size();
+            std::size_t e = network->graph.neighbors.size();
+            graphs += (v + 1) * sizeof(std::size_t) + e * sizeof(unsigned) + v * sizeof(std::string);
+            if (do_graphlets)
+            {
+                gdvs += v * (73 * sizeof(unsigned) + sizeof(std::vector<unsigned>));
+                if (!network->is_counted)
+                {
+                    counting += v * (v / 8 + 1) + v * 73 * sizeof(long long) + e * 3 * sizeof(void *);
+                }
+            }
+        }
+
+        std::size_t bio_file = do_bio ? FileIO::input_size(settings.bio_file) : 0;
+        auto top = do_topology ? matrix(pairs * sizeof(double)) : 0;
+        auto bio = do_bio ? bio_file + (is_streamed ? 0 : matrix(pairs * sizeof(double))) : 0;
+        auto building = gdvs + std::max(counting + bio, top + bio);
+
+        auto kept = is_kept ? top + (do_bio ? matrix(pairs * sizeof(double)) : 0) : 0;
+        auto candidates = g.graph.size() * settings.top_k * (sizeof(unsigned) + sizeof(double));
+        auto solving = gdvs + matrix(pairs * sizeof(double)) + kept + candidates + matrix(n * n * sizeof(double)) + n * n;
+
+        return graphs + std::max(building, solving);
+    }
+
+    /**
+     * Plan where to store the cost matrices of aligning G to H, within the memory limit of the settings.
+     *
+     * @param settings How to align the networks, with the memory limit and scratch directory.
+     * @param g The network G, read, and counted if it already was.
+     * @param h The network H, likewise.
+     * @param is_kept Whether the intermediates are kept for a later alignment, as in a sweep.
+     *
+     * @return The scratch directory to align with, and the peak memory expected with it: the given
+     * directory, if the alignment is expected to fit, else the system's temporary directory, storing
+     * the cost matrices out of core.
+     *
+     * @throws std::runtime_error If the alignment is not expected to fit within the limit even out of core.
+     */
+    std::pair<std::string, std::size_t> plan(const Settings &settings, const Network &g, const Network &h, bool is_kept)
+    {
+        auto bytes = memory_estimate(settings, g, h, is_kept);
+        if (bytes > settings.mem_limit && settings.scratch_dir == "")
+        {
+            auto out_of_core = settings;
+            out_of_core.scratch_dir = std::filesystem::temp_directory_path().string();
+            auto mapped_bytes = memory_estimate(out_of_core, g, h, is_kept);
+            if (mapped_bytes <= settings.mem_limit)
+            {
+                return {out_of_core.scratch_dir, mapped_bytes};
+            }
+            bytes = mapped_bytes;
+        }
+        if (bytes > settings.mem_limit)
+        {
+            throw std::runtime_error("Aligning " + g.name + " to " + h.name + " is expected to take " + Util::to_string(bytes / 1048576.0, 1) +
+                                     " MB of memory even out of core, over the limit of " + Util::to_string(settings.mem_limit / 1048576.0, 1) + " MB.");
+        }
+        return {settings.scratch_dir, bytes};
+    }
+
+    /*
+     * The inputs and parameters that determine the results of aligning G to H, by which checkpoints are
+     * matched to the alignment that made them. An input file is identified by its path, size and time of
+     * modification, so checkpoints of an input since changed are not resumed from.
+     */
+    std::string manifest(const Settings &settings, const Network &g, const Network &h)
+    {
+        auto stamp = [](std::string filepath)
+        {
+            std::error_code error;
+            auto size = std::filesystem::file_size(filepath, error);
+            auto bytes = error ? std::string("?") : std::to_string(size);
+            auto time = std::filesystem::last_write_time(filepath, error);
+            auto modified = error ? std::string("?") : std::to_string(time.time_since_epoch().count());
+            return filepath + " " + bytes + " " + modified;
+        };
+        return "G: " + stamp(g.file) + "\n" +
+               "H: " + stamp(h.file) + "\n" +
+               "B: " + (settings.bio_file == "" ? std::string("none") : stamp(settings.bio_file)) + "\n" +
+               "alpha: " + Util::to_string(settings.alpha, 17) + "\n" +
+               "beta: " + Util::to_string(settings.beta, 17) + "\n" +
+               "similarity threshold: " + Util::to_string(settings.similarity_threshold, 17) + "\n" +
+               "pruning: " + (settings.do_prune ? "yes" : "no") + "\n" +
+               "similarity conversion: " + (settings.do_similarity_conversion ? "yes" : "no") + "\n";
+    }
+
+    /*
+     * Align network G to network H, reusing and keeping the given intermediates.
+     */
+    Assignment align(const Settings &settings, Network &g, Network &h, Logger &log, Intermediates &kept);
+
+    /**
+     * Align network G to network H, writing the results and the log to the pair's output directory.
+     * The graphs are read, and their GDVs counted, only if that was not already done for an earlier
+     * alignment, so a network aligned to many others is only processed once.
+     *
+     * @param settings How to align the networks.
+     * @param g The network G, |G| <= |H|.
+     * @param h The network H.
+     * @param log The log of this alignment, opened in the output directory.
+     *
+     * @return The alignment of G to H.
+     *
+     * @throws std::runtime_error If an input could not be read, or an output could not be written.
+     */
+    Assignment align(const Settings &settings, Network &g, Network &h, Logger &log)
+    {
+        Intermediates kept;
+        return align(settings, g, h, log, kept);
+    }
+
+    Assignment align(const Settings &settings, Network &g, Network &h, Logger &log, Intermediates &kept)
+    {
+        const auto &bio_file = settings.bio_file;
+        auto alpha = settings.alpha;
+        auto beta = settings.beta;
+        auto similarity_threshold = settings.similarity_threshold;
+        auto do_passthrough = settings.do_passthrough;
+        auto do_similarity_conversion = settings.do_similarity_conversion;
+        auto scratch_dir = settings.scratch_dir; // may be chosen by the memory plan
+        auto do_binary_graphs = settings.do_binary_graphs;
+        auto do_npy = settings.do_npy;
+        auto is_quiet = settings.is_quiet;
+        auto top_k = settings.top_k;
+        auto do_bio = (bio_file != "");
+        const std::string CSV_SUFFIX = settings.do_compress ? ".gz" : ""; // appended to every CSV output
+
+        // Generate output names
+        auto &g_name = g.name;
+        auto &h_name = h.name;
+        auto bio_name = FileIO::name_file(bio_file, settings.bio_alias);
+        auto directory = FileIO::name_directory(settings.base_path, g_name, h_name, settings.datetime, settings.do_timestamp, settings.do_greekstamp,
+                                                settings.alpha_stamp, settings.beta_stamp, do_bio);
+        log.set_quiet(is_quiet);
+        log.set_level(settings.is_verbose ? Logger::DEBUG : Logger::INFO);
+        log.open(directory + LOG_FILENAME);
+
+        // Write log file
+        log.out(settings.command + "\n");
+        log.out("Y_M_D-H_M_S: " + settings.datetime + "\n");
+        log.out("\n");
+        log.out("INPUTS\n");
+        log.out("G File:               " + g_name + ".csv\n");
+        log.out("H File:               " + h_name + ".csv\n");
+        if (do_bio) log.out("Bio File:             " + bio_name + ".csv\n");
+        log.out("Alpha:                " + Util::to_string(alpha, 3) + "\n");
+        log.out("Beta:                 " + Util::to_string(beta, 3) + "\n");
+        log.out("Similarity threshold: " + Util::to_string(similarity_threshold, 3) + "\n");
+        if (scratch_dir != "") log.out("Scratch directory:    " + scratch_dir + "\n");
+        log.out("Threads:              " + std::to_string(Util::thread_budget()) + "\n", Logger::DEBUG);
+        log.out("\n");
+
+        log.out("BEGINNING ALIGNMENT\n");
+        Metrics metrics; // counts the work of every thread the alignment runs on
+        Metrics::Scope scope(&metrics);
+
+        // Plan which stages the parameters make relevant, as the library does
+        auto relevant = MiNAA::stages(options(settings), do_bio);
+        auto do_topology = relevant.do_topology;
+        auto do_graphlets = relevant.do_graphlets;
+
+        // With checkpoints, a stage saves its result once it completes, and a resumed stage loads the
+        // result an earlier run of the same alignment saved instead of calculating it again
+        std::optional<Checkpoint> checkpoint;
+        if (settings.checkpoint_s > 0)
+        {
+            checkpoint.emplace(directory + CHECKPOINT_DIRNAME, manifest(settings, g, h), settings.checkpoint_s, settings.do_resume);
+            if (settings.do_resume) log.out("Resuming from the checkpoints in " + directory + CHECKPOINT_DIRNAME + "\n");
+        }
+        auto is_saved = [&](std::string name) { return checkpoint.has_value() && checkpoint->has(name); };
+        auto save = [&](std::string name, const std::function<void(std::string)> &write)
+        {
+            if (checkpoint.has_value() && !checkpoint->has(name))
+            {
+                checkpoint->save(name, write);
+            }
+        };
+        auto is_g_resumed = !g.is_loaded && is_saved("G" + std::string(GRAPH_CHECKPOINT_SUFFIX));
+        auto is_h_resumed = !h.is_loaded && is_saved("H" + std::string(GRAPH_CHECKPOINT_SUFFIX));
+        auto is_counting_resumed = do_graphlets && !g.is_counted && !h.is_counted && is_saved("G" + std::string(GDVS_CHECKPOINT_SUFFIX)) &&
+                                   is_saved("H" + std::string(GDVS_CHECKPOINT_SUFFIX));
+        auto is_overall_resumed = do_bio && !do_passthrough && is_saved(OVERALL_COSTS_NPY_FILENAME); // the passthrough needs the parsed matrix
+
+        // Read a network's graph, from its checkpoint if it was saved, else from its file, saving it then
+        auto read = [&](Network &network, std::string role)
+        {
+            auto name = role + GRAPH_CHECKPOINT_SUFFIX;
+            if (!network.is_loaded && is_saved(name))
+            {
+                network.graph = FileIO::file_to_graph(checkpoint->path(name), false);
+                network.is_loaded = true;
+            }
+            else if (!network.is_loaded)
+            {
+                load(network);
+                save(name, [&](std::string filepath) { FileIO::graph_to_binary_file(filepath, network.graph); });
+            }
+        };
+
+        // Count a network's GDVs, or load them from its checkpoint if they were saved
+        auto count_or_resume = [&](Network &network, std::string role)
+        {
+            auto name = role + GDVS_CHECKPOINT_SUFFIX;
+            if (!network.is_counted && is_saved(name))
+            {
+                network.gdvs = FileIO::npy_file_to_gdvs(checkpoint->path(name));
+                network.is_counted = true;
+            }
+            count(network);
+        };
+
+        // With a memory limit, read the graphs first and plan by their sizes: out of core if the cost
+        // matrices would not fit in memory, or not at all if they would not fit even then, before any work
+        long long planned_read_ms = 0;
+        if (settings.mem_limit > 0)
+        {
+            TaskGraph reads;
+            auto read_g = reads.add([&]() { read(g, "G"); });
+            auto read_h = reads.add([&]() { read(h, "H"); });
+            reads.run(Util::thread_budget());
+            planned_read_ms = reads.elapsed_ms({read_g, read_h});
+
+            auto planned = plan(settings, g, h, kept.is_kept);
+            scratch_dir = planned.first;
+            log.out("Planning memory use............................" + (scratch_dir == "" ? std::string("in memory.") : "out of core, in " + scratch_dir + ".") +
+                    " (about " + Util::to_string(planned.second / 1048576.0, 1) + " of " + Util::to_string(settings.mem_limit / 1048576.0, 1) + " MB)\n");
+        }
+
+        auto is_streamed = do_bio && scratch_dir != "" && do_topology && !do_passthrough && !kept.is_kept && !is_overall_resumed; // see below
+
+        // Results are written in the background while later stages run. The writer is declared after the
+        // results it reads, so it finishes every write before they are destroyed, and a result is never
+        // modified once its write is queued. The GDVs are kept with the networks, and the topological costs
+        // with the intermediates, which both outlive the writer.
+        const auto &g_graph = g.graph;
+        const auto &h_graph = h.graph;
+        const auto &g_labels = g_graph.labels;
+        const auto &h_labels = h_graph.labels;
+        auto &topological_costs = kept.topological_costs;
+        CostMatrix parsed;
+        auto &biological_costs = kept.is_kept ? kept.biological_costs : parsed;
+        CostMatrix overall_costs;
+        Candidates candidates;
+        Assignment alignment;
+        AsyncWriter writer;
+
+        // The stages up to the overall cost matrix, as a graph of tasks: reading G and H, counting their
+        // GDVs and parsing the biological matrix are independent, so they overlap, and each stage starts
+        // as soon as its inputs are ready. Stages are logged in order once they have all finished.
+        auto is_top_reused = !topological_costs.empty() && kept.alpha == alpha && kept.cutoff == relevant.cutoff;
+        auto is_bio_reused = !biological_costs.empty();
+        auto is_normalized = do_passthrough || !do_topology || kept.is_kept; // else fused into combining
+        TaskGraph stages;
+        auto read_g = stages.add([&]() { read(g, "G"); });
+        auto read_h = stages.add([&]() { read(h, "H"); });
+        std::vector<TaskGraph::Task> graph_writes;
+        if (do_binary_graphs)
+        {
+            // Write graph objects to binary CSR files, for fast reloading
+            graph_writes.push_back(stages.add([&]()
+            {
+                FileIO::graph_to_binary_file(directory + g_name + ".csr", g_graph);
+                FileIO::graph_to_binary_file(directory + h_name + ".csr", h_graph);
+            }, {read_g, read_h}));
+        }
+        if (do_passthrough)
+        {
+            // Write graph objects back to files
+            graph_writes.push_back(stages.add([&]()
+            {
+                FileIO::graph_to_file(directory + g_name + ".csv" + CSV_SUFFIX, g_graph);
+                FileIO::graph_to_file(directory + h_name + ".csv" + CSV_SUFFIX, h_graph);
+            }, {read_g, read_h}));
+        }
+        if (do_npy)
+        {
+            // Write the labels that index the rows and columns of the .npy outputs
+            graph_writes.push_back(stages.add([&]()
+            {
+                FileIO::labels_to_file(directory + g_name + "_labels.txt", g_labels);
+                FileIO::labels_to_file(directory + h_name + "_labels.txt", h_labels);
+            }, {read_g, read_h}));
+        }
+        std::vector<TaskGraph::Task> counts;
+        if (do_graphlets)
+        {
+            // Calculate the GDVs for G and H, then write them to files
+            counts.push_back(stages.add([&]() { count_or_resume(g, "G"); }, {read_g}));
+            counts.push_back(stages.add([&]() { count_or_resume(h, "H"); }, {read_h}));
+            stages.add([&, directory]()
+            {
+                writer.submit([&, directory]()
+                {
+                    if (do_npy)
+                    {
+                        FileIO::gdvs_to_npy_file(directory + g_name + "_gdvs.npy", g.gdvs);
+                        FileIO::gdvs_to_npy_file(directory + h_name + "_gdvs.npy", h.gdvs);
+                    }
+                    else
+                    {
+                        FileIO::gdvs_to_file(directory + g_name + "_gdvs.csv" + CSV_SUFFIX, g_labels, g.gdvs);
+                        FileIO::gdvs_to_file(directory + h_name + "_gdvs.csv" + CSV_SUFFIX, h_labels, h.gdvs);
+                    }
+                    save("G" + std::string(GDVS_CHECKPOINT_SUFFIX), [&](std::string filepath) { FileIO::gdvs_to_npy_file(filepath, g.gdvs); });
+                    save("H" + std::string(GDVS_CHECKPOINT_SUFFIX), [&](std::string filepath) { FileIO::gdvs_to_npy_file(filepath, h.gdvs); });
+                });
+            }, counts);
+        }
+        std::vector<TaskGraph::Task> top;
+        auto is_top_resumed = do_topology && !is_top_reused && is_saved(TOP_COSTS_NPY_FILENAME);
+        if (do_topology)
+        {
+            // Calculate the topological similarity matrix, pruning pairs too dissimilar to ever be reported,
+            // unless it was already calculated for this alpha or is resumed, then write it to a file
+            if (is_top_resumed)
+            {
+                top.push_back(stages.add([&]()
+                {
+                    topological_costs = FileIO::npy_file_to_matrix(checkpoint->path(TOP_COSTS_NPY_FILENAME), scratch_dir);
+                    kept.alpha = alpha;
+                    kept.cutoff = relevant.cutoff;
+                }));
+            }
+            else if (!is_top_reused)
+            {
+                top.push_back(stages.add([&]()
+                {
+                    topological_costs = MiNAA::topological_costs(relevant, alpha, g_graph, h_graph, g.gdvs, h.gdvs, scratch_dir);
+                    kept.alpha = alpha;
+                    kept.cutoff = relevant.cutoff;
+                }, do_graphlets ? counts : std::vector<TaskGraph::Task>{read_g, read_h}));
+            }
+            stages.add([&, directory]()
+            {
+                writer.submit([&, directory]()
+                {
+                    if (do_npy)
+                    {
+                        FileIO::matrix_to_npy_file(directory + TOP_COSTS_NPY_FILENAME, topological_costs);
+                    }
+                    else
+                    {
+                        FileIO::matrix_to_file(directory + TOP_COSTS_FILENAME + CSV_SUFFIX, g_labels, h_labels, topological_costs);
+                    }
+                    save(TOP_COSTS_NPY_FILENAME, [&](std::string filepath) { FileIO::matrix_to_npy_file(filepath, topological_costs); });
+                });
+            }, top);
+        }
+        std::vector<TaskGraph::Task> bio;
+        std::vector<TaskGraph::Task> bio_write;
+        if (do_bio && !is_streamed && !is_overall_resumed)
+        {
+            // Parse the biological cost matrix, normalizing it (and converting similarities to costs) now
+            // only if it is needed on its own or kept; otherwise that is fused into combining the cost matrices
+            if (!is_bio_reused)
+            {
+                bio.push_back(stages.add([&]()
+                {
+                    biological_costs = FileIO::file_to_cost_matrix(bio_file, scratch_dir, g_labels, h_labels, do_similarity_conversion);
+                    if (is_normalized)
+                    {
+                        Util::normalize(biological_costs, do_similarity_conversion);
+                    }
+                }, {read_g, read_h}));
+            }
+            if (do_passthrough)
+            {
+                // Written before the overall cost matrix is calculated in its place
+                bio_write.push_back(stages.add([&]()
+                {
+                    if (do_npy)
+                    {
+                        FileIO::matrix_to_npy_file(directory + BIO_COSTS_NPY_FILENAME, biological_costs);
+                    }
+                    else
+                    {
+                        FileIO::matrix_to_file(directory + BIO_COSTS_FILENAME + CSV_SUFFIX, g_labels, h_labels, biological_costs);
+                    }
+                }, bio));
+            }
+        }
+        stages.run(Util::thread_budget());
+
+        // Record the stages that ran, then log them in order
+        auto read_ms = planned_read_ms + stages.elapsed_ms({read_g, read_h});
+        metrics.record("read_graphs", read_ms);
+        if (!graph_writes.empty()) metrics.record("write_graphs", stages.elapsed_ms(graph_writes));
+        if (do_graphlets) metrics.record("count_gdvs", stages.elapsed_ms(counts));
+        if (!top.empty()) metrics.record("topological_costs", stages.elapsed_ms(top));
+        if (!bio.empty()) metrics.record("biological_costs", stages.elapsed_ms(bio));
+        if (!bio_write.empty()) metrics.record("write_biological_costs", stages.elapsed_ms(bio_write));
+
+        log.out("Reading graph files............................" + std::string(is_g_resumed && is_h_resumed ? "resumed" : "done") +
+                ". (" + std::to_string(read_ms) + "ms)\n");
+        log.out("G: " + std::to_string(g_graph.size()) + " nodes, " + std::to_string(g_graph.neighbors.size()) + " adjacency entries\n", Logger::DEBUG);
+        log.out("H: " + std::to_string(h_graph.size()) + " nodes, " + std::to_string(h_graph.neighbors.size()) + " adjacency entries\n", Logger::DEBUG);
+        if (!graph_writes.empty())
+        {
+            log.out("Writing graph files............................done. (" + std::to_string(stages.elapsed_ms(graph_writes)) + "ms)\n");
+        }
+        if (do_graphlets)
+        {
+            log.out("Calculating GDVs..............................." + std::string(is_counting_resumed ? "resumed" : "done") +
+                    ". (" + std::to_string(stages.elapsed_ms(counts)) + "ms)\n");
+            log.out("Writing GDVs to files..........................queued.\n");
+        }
+        else
+        {
+            log.out("Calculating GDVs...............................skipped. (" +
+                                 std::string(do_topology ? "alpha = 0" : "beta = 0") + ")\n");
+        }
+        if (do_topology)
+        {
+            log.out("Calculating the topological cost matrix........" +
+                    (is_top_reused ? std::string("reused.") : (is_top_resumed ? "resumed. (" : "done. (") + std::to_string(stages.elapsed_ms(top)) + "ms)") + "\n");
+            log.out("Writing the topological cost matrix to file....queued.\n");
+        }
+        else
+        {
+            log.out("Calculating the topological cost matrix........skipped. (beta = 0)\n");
+        }
+
+        if (do_bio) // incorporate biological data
+        {
+            // Out of core, stream the biological matrix into the topological one instead of loading it,
+            // unless it is needed on its own
+            if (is_overall_resumed)
+            {
+                log.out("Processing biological data.....................resumed.\n");
+
+                log.out("Calculating the overall cost matrix............");
+                Metrics::Timer timer(metrics, "overall_costs");
+                overall_costs = FileIO::npy_file_to_matrix(checkpoint->path(OVERALL_COSTS_NPY_FILENAME), scratch_dir);
+                if (do_topology && !kept.is_kept)
+                {
+                    writer.submit([&]() { topological_costs = CostMatrix(); });
+                }
+                log.out("resumed. (" + std::to_string(timer.stop()) + "ms)\n");
+            }
+            else if (is_streamed)
+            {
+                log.out("Processing biological data.....................streamed.\n");
+
+                // Combine in place of the topological costs, once they are written
+                log.out("Calculating the overall cost matrix............");
+                Metrics::Timer timer(metrics, "overall_costs");
+                writer.wait();
+                Util::combine_streamed(topological_costs, bio_file, scratch_dir, g_labels, h_labels, beta, do_similarity_conversion);
+                overall_costs = std::move(topological_costs);
+                log.out("done. (" + std::to_string(timer.stop()) + "ms)\n");
+            }
+            else
+            {
+                log.out("Processing biological data....................." +
+                        (is_bio_reused ? std::string("reused.") : "done. (" + std::to_string(stages.elapsed_ms(bio)) + "ms)") + "\n");
+                if (do_passthrough)
+                {
+                    log.out("Writing biological data file...................done. (" + std::to_string(stages.elapsed_ms(bio_write)) + "ms)\n");
+                }
+
+                // Calculate the overall cost matrix in place of the biological one, or beside it if it is
+                // kept, which is just the biological one if the topology carries no weight
+                log.out("Calculating the overall cost matrix............");
+                Metrics::Timer timer(metrics, "overall_costs");
+                if (kept.is_kept)
+                {
+                    overall_costs = Util::blend(topological_costs, biological_costs, do_topology ? beta : 0, scratch_dir);
+                }
+                else
+                {
+                    if (do_topology)
+                    {
+                        Util::combine(topological_costs, biological_costs, beta, !is_normalized, do_similarity_conversion && !is_normalized);
+
+                        // The topological costs are not needed again, so release them once they are written
+                        writer.submit([&]() { topological_costs = CostMatrix(); });
+                    }
+                    overall_costs = std::move(biological_costs);
+                }
+                log.out("done. (" + std::to_string(timer.stop()) + "ms)\n");
+            }
+
+            // Store the overall cost matrix in a file
+            log.out("Writing the overall cost matrix to file........queued.\n");
+            writer.submit([&, directory]()
+            {
+                if (do_npy)
+                {
+                    FileIO::matrix_to_npy_file(directory + OVERALL_COSTS_NPY_FILENAME, overall_costs);
+                }
+                else
+                {
+                    FileIO::matrix_to_file(directory + OVERALL_COSTS_FILENAME + CSV_SUFFIX, g_labels, h_labels, overall_costs);
+                }
+                save(OVERALL_COSTS_NPY_FILENAME, [&](std::string filepath) { FileIO::matrix_to_npy_file(filepath, overall_costs); });
+            });
+        }
+
+        // The cost matrix to align by
+        const auto &costs = do_bio ? overall_costs : topological_costs;
+
+        if (top_k > 0)
+        {
+            // Select each node's best candidates while the cost matrix is at hand, then store them in a file
+            log.out("Selecting the top candidates...................");
+            Metrics::Timer timer(metrics, "candidates");
+            candidates = Util::top_k(costs, top_k);
+            log.out("done. (" + std::to_string(timer.stop()) + "ms)\n");
+
+            log.out("Writing the candidates to file.................queued.\n");
+            writer.submit([&, directory]()
+            {
+                FileIO::candidates_to_file(directory + CANDIDATES_FILENAME + CSV_SUFFIX, g_labels, h_labels, candidates);
+            });
+        }
+
+        // Run the alignment algorithm
+        log.out("Aligning the graphs............................");
+        if (!is_quiet) std::cout << std::endl; // PROGRESS
+        Metrics::Timer align_timer(metrics, "alignment");
+        alignment = Hungarian::hungarian(costs, scratch_dir, !is_quiet, checkpoint.has_value() ? &*checkpoint : nullptr);
+        auto align_ms = align_timer.stop();
+        if (!is_quiet) std::cout << "\33[2K\r"; // PROGRESS
+        log.out("done. (" + std::to_string(align_ms) + "ms)\n");
+
+        // Write the alignment to csv files, the list in the background while this thread writes the matrix,
+        // then wait for every queued write to finish
+        log.out("Writing the alignment to file..................");
+        Metrics::Timer write_timer(metrics, "write_alignment");
+        writer.submit([&, directory]()
+        {
+            FileIO::alignment_to_list_file(directory + ALIGNMENT_LIST_FILENAME + CSV_SUFFIX, g_labels, h_labels, alignment, similarity_threshold);
+        });
+        FileIO::alignment_to_matrix_file(directory + ALIGNMENT_MATRIX_FILENAME + CSV_SUFFIX, g_labels, h_labels, alignment, similarity_threshold);
+        writer.wait();
+        log.out("done. (" + std::to_string(write_timer.stop()) + "ms)\n");
+
+        // The alignment is complete, so its checkpoints are no longer needed
+        if (checkpoint.has_value())
+        {
+            checkpoint->remove();
+        }
+
+        // Store the measurements of the alignment in a file
+        FileIO::metrics_to_file(directory + METRICS_FILENAME, metrics);
+        log.out("ALIGNMENT COMPLETED (" + std::to_string(metrics.elapsed_ms()) + "ms)\n");
+
+        return alignment;
+    }
+
+    /**
+     * Align every pair of networks from the two given sets, in parallel, and write a summary of the net
+     * cost of each alignment. Every network is first read, and its GDVs counted, exactly once, in
+     * parallel. Alignments then run on a pool of one worker per hardware thread, largest first, and only
+     * as many at once as the memory limit, or else the machine's memory, is expected to hold; a pair too
+     * big to fit runs alone. Each alignment is written to its own output directory as usual, and a failed one is logged there
+     * without stopping the others.
+     *
+     * @param settings How to align the networks.
+     * @param g_set The networks to align as G.
+     * @param h_set The networks to align as H.
+     * @param is_same_set Whether the sets are the same, in which case each unordered pair is aligned once,
+     *                    with the smaller network as G.
+     *
+     * @return The number of alignments that failed.
+     *
+     * @throws std::runtime_error If the summary could not be written.
+     */
+    std::size_t align_all(const Settings &settings, std::vector<Network> &g_set, std::vector<Network> &h_set, bool is_same_set)
+    {
+        auto do_graphlets = MiNAA::stages(options(settings), settings.bio_file != "").do_graphlets;
+
+        // Read every network and count its GDVs, once each, in parallel
+        std::vector<Network *> networks;
+        for (auto &g : g_set)
+        {
+            networks.push_back(&g);
+        }
+        if (!is_same_set)
+        {
+            for (auto &h : h_set)
+            {
+                networks.push_back(&h);
+            }
+        }
+        if (!settings.is_quiet) std::cout << "Reading " << networks.size() << " networks..." << std::endl;
+        std::vector<std::string> errors(networks.size());
+        auto read_share = std::max<std::size_t>(1, Util::thread_budget() / std::max<std::size_t>(1, networks.size()));
+        Util::parallel_for(networks.size(), 1, [&](std::size_t begin, std::size_t end)
+        {
+            auto threads = Util::thread_budget();
+            Util::set_thread_budget(read_share); // the networks read at once share the threads
+            for (auto i = begin; i < end; ++i)
+            {
+                try
+                {
+                    load(*networks[i]);
+                    if (do_graphlets)
+                    {
+                        count(*networks[i]);
+                    }
+                }
+                catch (std::exception &e)
+                {
+                    errors[i] = e.what();
+                }
+            }
+            Util::set_thread_budget(threads);
+        });
+
+        // Plan the alignments, largest first, each as it will be run within the memory limit if one is set;
+        // a pair that cannot fit takes no memory here, since it fails before allocating any
+        auto job_bytes = [&](const Network &g, const Network &h) -> std::size_t
+        {
+            if (settings.mem_limit == 0)
+            {
+                return memory_estimate(settings, g, h, false);
+            }
+            try
+            {
+                return plan(settings, g, h, false).second;
+            }
+            catch (std::runtime_error &)
+            {
+                return 0;
+            }
+        };
+        struct Job
+        {
+            Network *g;
+            Network *h;
+            std::size_t bytes;
+            double net_cost;
+        };
+        std::vector<Job> jobs;
+        for (std::size_t i = 0; i < g_set.size(); ++i)
+        {
+            for (std::size_t j = is_same_set ? i + 1 : 0; j < h_set.size(); ++j)
+            {
+                auto *g = &g_set[i];
+                auto *h = &h_set[j];
+                if (is_same_set && g->graph.size() > h->graph.size())
+                {
+                    std::swap(g, h);
+                }
+                jobs.push_back({g, h, job_bytes(*g, *h), std::numeric_limits<double>::quiet_NaN()});
+            }
+        }
+        std::stable_sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.bytes > b.bytes; });
+
+        // Run the alignments on a worker pool, admitting a job only while the memory in use allows it
+        auto budget = (settings.mem_limit > 0) ? settings.mem_limit : Util::physical_memory() / 4 * 3;
+        auto job_settings = settings;
+        job_settings.is_quiet = true; // the workers' logs would interleave on the console
+        std::mutex mutex;
+        std::condition_variable admitted;
+        std::vector<bool> is_started(jobs.size(), false);
+        std::size_t started = 0;
+        std::size_t finished = 0;
+        std::size_t failures = 0;
+        std::size_t in_use = 0;
+        auto work = [&]()
+        {
+            while (true)
+            {
+                std::size_t k = jobs.size();
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    admitted.wait(lock, [&]()
+                    {
+                        if (started == jobs.size())
+                        {
+                            return true;
+                        }
+                        for (std::size_t i = 0; i < jobs.size(); ++i)
+                        {
+                            if (!is_started[i] && (in_use == 0 || budget == 0 || in_use + jobs[i].bytes <= budget))
+                            {
+                                k = i;
+                                return true;
+                            }
+                        }
+                        return false;
+                    });
+                    if (k == jobs.size())
+                    {
+                        return;
+                    }
+                    is_started[k] = true;
+                    ++started;
+                    in_use += jobs[k].bytes;
+                }
+
+                auto &job = jobs[k];
+                auto ok = false;
+                {
+                    Logger log;
+                    try
+                    {
+                        for (auto *network : {job.g, job.h})
+                        {
+                            auto i = std::find(networks.begin(), networks.end(), network) - networks.begin();
+                            if (errors[i] != "")
+                            {
+                                throw std::runtime_error(errors[i]);
+                            }
+                        }
+                        job.net_cost = Util::net_cost(align(job_settings, *job.g, *job.h, log), settings.similarity_threshold);
+                        ok = true;
+                    }
+                    catch (std::exception &e)
+                    {
+                        log.err(job.g->name + "-" + job.h->name + ": " + e.what());
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                in_use -= job.bytes;
+                ++finished;
+                failures += !ok;
+                if (!settings.is_quiet)
+                {
+                    std::cout << "Aligned " << job.g->name << " to " << job.h->name << (ok ? "" : " (failed)")
+                              << " (" << finished << " of " << jobs.size() << ")" << std::endl;
+                }
+                admitted.notify_all();
+            }
+        };
+
+        // The workers share the thread budget, so concurrent alignments do not each start a thread per core
+        std::vector<std::thread> pool;
+        auto threads = Util::thread_budget();
+        auto workers = std::min(jobs.size(), threads);
+        for (std::size_t t = 0; t < workers; ++t)
+        {
+            auto share = threads / workers + (t < threads % workers);
+            pool.emplace_back([&work, share]()
+            {
+                Util::set_thread_budget(share);
+                work();
+            });
+        }
+        for (auto &thread : pool)
+        {
+            thread.join();
+        }
+
+        // Summarize the net cost of every alignment
+        std::vector<std::string> pairs;
+        std::vector<double> net_costs;
+        for (auto &job : jobs)
+        {
+            pairs.push_back(job.g->name + "," + job.h->name);
+            net_costs.push_back(job.net_cost);
+        }
+        std::filesystem::create_directories(settings.base_path);
+        auto summary = settings.base_path + "/" + SUMMARY_FILENAME;
+        if (settings.do_timestamp)
+        {
+            summary = settings.base_path + "/summary-" + settings.datetime + ".csv";
+        }
+        FileIO::summary_to_file(summary + (settings.do_compress ? ".gz" : ""), "g_network,h_network", pairs, net_costs);
+        if (!settings.is_quiet) std::cout << "Summary written to " << summary << (settings.do_compress ? ".gz" : "") << std::endl;
+
+        return failures;
+    }
+
+    /**
+     * Align network G to network H for every combination of the given alphas and betas, reusing every
+     * intermediate that a setting shares with the one before it. The GDVs are counted and the biological
+     * matrix parsed and normalized once, one topological cost matrix is kept at a time, for the alpha
+     * being swept, and only the blend of the two is recalculated for each beta. Each setting is written to
+     * its own output directory, named as with a greekstamp, in a parent directory for the pair that also
+     * holds a summary of the net cost of every setting.
+     *
+     * @param settings How to align the networks, but for alpha and beta.
+     * @param g The network G, |G| <= |H|.
+     * @param h The network H.
+     * @param alphas The values of alpha to align with, as given.
+     * @param betas The values of beta to align with, as given.
+     *
+     * @return The number of settings whose alignment failed.
+     *
+     * @throws std::runtime_error If the parent directory or the summary could not be written.
+     */
+    std::size_t sweep(const Settings &settings, Network &g, Network &h, const std::vector<std::string> &alphas,
+                      const std::vector<std::string> &betas)
+    {
+        auto do_bio = (settings.bio_file != "");
+        auto parent = FileIO::name_directory(settings.base_path, g.name, h.name, settings.datetime, settings.do_timestamp, false,
+                                             "", "", do_bio);
+
+        Logger sweep_log;
+        sweep_log.set_quiet(true);
+        sweep_log.open(parent + LOG_FILENAME);
+        sweep_log.out(settings.command + "\n");
+        sweep_log.out("Y_M_D-H_M_S: " + settings.datetime + "\n");
+        sweep_log.out("\n");
+        sweep_log.out("SWEEP\n");
+
+        auto setting = settings;
+        setting.base_path = parent.substr(0, parent.size() - 1);
+        setting.do_timestamp = false;
+        setting.do_greekstamp = true;
+
+        Intermediates kept;
+        kept.is_kept = true;
+        std::vector<std::string> keys;
+        std::vector<double> net_costs;
+        std::size_t failures = 0;
+        for (const auto &alpha : alphas)
+        {
+            for (const auto &beta : betas)
+            {
+                setting.alpha = std::stod(alpha);
+                setting.beta = std::stod(beta);
+                setting.alpha_stamp = alpha;
+                setting.beta_stamp = beta;
+                keys.push_back(alpha + "," + beta);
+                net_costs.push_back(std::numeric_limits<double>::quiet_NaN());
+
+                if (!settings.is_quiet) std::cout << "SETTING " << keys.size() << " OF " << alphas.size() * betas.size()
+                                                  << ": alpha = " << alpha << ", beta = " << beta << "\n\n";
+                Logger log;
+                try
+                {
+                    net_costs.back() = Util::net_cost(align(setting, g, h, log, kept), settings.similarity_threshold);
+                    sweep_log.out("alpha = " + alpha + ", beta = " + beta + ": net cost " + std::to_string(net_costs.back()) + "\n");
+                }
+                catch (std::exception &e)
+                {
+                    log.err(e.what());
+                    sweep_log.out("alpha = " + alpha + ", beta = " + beta + ": failed\n");
+                    ++failures;
+                }
+                if (!settings.is_quiet) std::cout << std::endl;
+            }
+        }
+
+        auto suffix = settings.do_compress ? ".gz" : "";
+        FileIO::summary_to_file(parent + SWEEP_SUMMARY_FILENAME + suffix, "alpha,beta", keys, net_costs);
+        if (!settings.is_quiet) std::cout << "Summary written to " << parent << SWEEP_SUMMARY_FILENAME << suffix << std::endl;
+
+        return failures;
+    }
+}
@@ -0,0 +1,323 @@
+// server.cpp
+// Alignment Daemon on a Unix Domain Socket
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "assignment.h"
+#include "candidates.h"
+#include "cost_matrix.h"
+#include "graph.h"
+#include "logger.h"
+#include "metrics.h"
+#include "network.h"
+#include "network_cache.h"
+#include "settings.h"
+#include "pipeline.h"
+#include "file_io.h"
+#include "util.h"
+
+namespace Server
+{
+    const std::size_t MAX_REQUEST = 1 << 16; // the longest request line, in bytes
+    const int BACKLOG = 64;                  // the most connections waiting to be accepted
+
+    #ifndef _WIN32 // Unix
+    char socket_path[sizeof(sockaddr_un::sun_path)]; // to remove on shutdown
+
+    /*
+     * Remove the socket and stop, on an interrupt or termination signal.
+     */
+    void stop(int)
+    {
+        unlink(socket_path);
+        _exit(0);
+    }
+
+    /*
+     * Read a request from a connection, up to the first newline or the end of the connection.
+     */
+    std::string read_request(int fd)
+    {
+        std::string request;
+        char buffer[4096];
+        while (request.find('\n') == std::string::npos)
+        {
+            auto n = read(fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            request.append(buffer, n);
+            if (request.size() > MAX_REQUEST)
+            {
+                throw std::invalid_argument("The request is longer than " + std::to_string(MAX_REQUEST) + " bytes.");
+            }
+        }
+        request.erase(std::min(request.find('\n'), request.size()));
+        if (!request.empty() && request.back() == '\r')
+        {
+            request.pop_back();
+        }
+        return request;
+    }
+
+    /*
+     * Write a reply line to a connection, ignoring a client that has gone away.
+     */
+    void write_reply(int fd, std::string reply)
+    {
+        reply += "\n";
+        std::size_t sent = 0;
+        while (sent < reply.size())
+        {
+            auto n = send(fd, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return;
+            }
+            sent += n;
+        }
+    }
+    #endif
+
+    /*
+     * The output directories that requests are writing, so that requests for the same directory, such as
+     * two of the same pair within the same second, run one after the other rather than both writing it.
+     */
+    std::mutex directories_mutex;
+    std::condition_variable directory_released;
+    std::set<std::string> directories_in_use;
+
+    /*
+     * Holds an output directory for one request, waiting until no other request holds it.
+     */
+    class DirectoryClaim
+    {
+    public:
+        explicit DirectoryClaim(std::string directory) : directory_(directory)
+        {
+            std::unique_lock<std::mutex> lock(directories_mutex);
+            directory_released.wait(lock, [&]() { return directories_in_use.count(directory_) == 0; });
+            directories_in_use.insert(directory_);
+        }
+
+        ~DirectoryClaim()
+        {
+            {
+                std::lock_guard<std::mutex> lock(directories_mutex);
+                directories_in_use.erase(directory_);
+            }
+            directory_released.notify_all();
+        }
+
+        DirectoryClaim(const DirectoryClaim &) = delete;
+        DirectoryClaim &operator=(const DirectoryClaim &) = delete;
+
+    private:
+        std::string directory_;
+    };
+
+    /*
+     * Align the pair of networks a request names, with the command line arguments it gives, taking the
+     * networks from the cache, once no other request is writing its output directory. Returns the net
+     * cost of the alignment.
+     */
+    double handle(std::string request, NetworkCache &cache)
+    {
+        std::vector<std::string> tokens = {"minaa.exe"};
+        std::istringstream words(request);
+        std::string word;
+        while (words >> word)
+        {
+            tokens.push_back(word);
+        }
+        std::vector<char *> argv;
+        for (auto &token : tokens)
+        {
+            argv.push_back(token.data());
+        }
+        argv.push_back(nullptr);
+
+        auto args = Util::parse_args(tokens.size(), argv.data());
+        if (FileIO::is_network_set(args[1]) || FileIO::is_network_set(args[2]) ||
+            args[4].find(',') != std::string::npos || args[5].find(',') != std::string::npos)
+        {
+            throw std::invalid_argument("The server aligns a single pair of networks, with one alpha and one beta.");
+        }
+
+        auto settings = Pipeline::settings(args, "Serving:     " + request + " ");
+        settings.is_quiet = true; // requests run concurrently, so only their logs are written
+
+        // Count the GDVs whenever the alignment needs them, as the pipeline would
+        auto do_count = settings.alpha != 0 && !(settings.bio_file != "" && settings.beta == 0);
+        auto g = cache.get(args[1], args[7], do_count);
+        auto h = cache.get(args[2], args[8], do_count);
+
+        auto directory = FileIO::name_directory(settings.base_path, g.name, h.name, settings.datetime, settings.do_timestamp, settings.do_greekstamp,
+                                                settings.alpha_stamp, settings.beta_stamp, settings.bio_file != "");
+        DirectoryClaim claim(std::filesystem::absolute(directory).lexically_normal().string());
+
+        Logger log;
+        try
+        {
+            return Util::net_cost(Pipeline::align(settings, g, h, log), settings.similarity_threshold);
+        }
+        catch (std::exception &e)
+        {
+            log.err(g.name + "-" + h.name + ": " + e.what());
+            throw;
+        }
+    }
+
+    /**
+     * Serve alignments on a Unix domain socket until interrupted or terminated.
+     * Each connection sends one request: a line with the arguments of an alignment of a pair of
+     * networks, as they would follow the program name on the command line. The alignment is written to
+     * its output directory as usual, and the server replies with one line: "OK" and the net cost of the
+     * alignment, or "ERROR" and what went wrong. Requests are processed concurrently, one per thread,
+     * sharing the threads for their own parallel work, but requests for the same output directory wait their turn.
+     * Networks are kept between requests, read and with their GDVs counted, so a network aligned again
+     * is not processed again.
+     *
+     * @param path The path of the socket to listen on.
+     * @param cache_size The most networks to keep between requests.
+     *
+     * @throws std::runtime_error If the socket could not be made, or is already being served on.
+     */
+    void serve(std::string path, std::size_t cache_size)
+    {
+        #ifndef _WIN32 // Unix
+        if (path.size() >= sizeof(socket_path))
+        {
+            throw std::runtime_error("The socket path must be shorter than " + std::to_string(sizeof(socket_path)) + " characters.");
+        }
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, path.c_str());
+
+        // Replace a socket left behind by a server that has stopped, but not one still serving
+        if (std::filesystem::is_socket(path))
+        {
+            int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+            auto is_served = probe != -1 && connect(probe, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+            close(probe);
+            if (is_served)
+            {
+                throw std::runtime_error("A server is already listening on " + path);
+            }
+            unlink(path.c_str());
+        }
+
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener == -1)
+        {
+            throw std::runtime_error(std::string("Unable to create a socket: ") + std::strerror(errno));
+        }
+        if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1 || listen(listener, BACKLOG) == -1)
+        {
+            auto reason = std::string(std::strerror(errno));
+            close(listener);
+            throw std::runtime_error("Unable to listen on " + path + ": " + reason);
+        }
+        std::strcpy(socket_path, path.c_str());
+        std::signal(SIGINT, stop);
+        std::signal(SIGTERM, stop);
+        std::cout << "Listening on " << path << std::endl;
+
+        // Accept connections on this thread, and process them on a pool of workers
+        // Each request takes an equal share of the threads with those already running
+        NetworkCache cache(cache_size);
+        std::deque<int> connections;
+        std::mutex mutex;
+        std::condition_variable queued;
+        auto threads = Util::thread_budget();
+        std::size_t running = 0;
+        auto work = [&]()
+        {
+            while (true)
+            {
+                int fd;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    queued.wait(lock, [&]() { return !connections.empty(); });
+                    fd = connections.front();
+                    connections.pop_front();
+                    ++running;
+                    Util::set_thread_budget(std::max<std::size_t>(1, threads / running));
+                }
+
+                std::string reply;
+                try
+                {
+                    reply = "OK " + std::to_string(handle(read_request(fd), cache));
+                }
+                catch (std::exception &e)
+                {
+                    std::string reason = e.what();
+                    std::replace(reason.begin(), reason.end(), '\n', ' ');
+                    reply = "ERROR " + reason;
+                }
+                write_reply(fd, reply);
+                close(fd);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                --running;
+            }
+        };
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back(work);
+        }
+
+        while (true)
+        {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd == -1)
+            {
+                continue; // e.g. interrupted, or the client gave up
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                connections.push_back(fd);
+            }
+            queued.notify_one();
+        }
+        #else
+        (void)path;
+        (void)cache_size;
+        throw std::runtime_error("Serving on a Unix domain socket is not supported on Windows.");
+        #endif
+    }
+}
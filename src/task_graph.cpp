@@ -0,0 +1,178 @@
+// task_graph.cpp
+// Concurrent Execution of Dependent Stages
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "assignment.h"
+#include "candidates.h"
+#include "cost_matrix.h"
+#include "graph.h"
+#include "metrics.h"
+#include "task_graph.h"
+#include "util.h"
+
+/**
+ * Add a task to the graph.
+ *
+ * @param fn The work of the task.
+ * @param after The tasks that must finish before this one starts, which must already be added.
+ *
+ * @return The task, by which later tasks may come after it.
+ *
+ * @throws std::invalid_argument If a task to come after has not been added.
+ */
+TaskGraph::Task TaskGraph::add(std::function<void()> fn, std::vector<Task> after)
+{
+    Task task = nodes_.size();
+    for (auto before : after)
+    {
+        if (before >= task)
+        {
+            throw std::invalid_argument("A task can only come after a task added before it.");
+        }
+    }
+
+    Node node;
+    node.fn = std::move(fn);
+    node.waiting = after.size();
+    nodes_.push_back(std::move(node));
+    for (auto before : after)
+    {
+        nodes_[before].next.push_back(task);
+    }
+    return task;
+}
+
+/**
+ * Run every task, each once the tasks it comes after have finished, on up to the given number of
+ * threads, including the calling one, each with the thread budget of the calling one for its own
+ * parallel work. Ready tasks start in the order they were added.
+ * Once a task fails no more tasks start, and the error is rethrown when the running ones have finished.
+ *
+ * @param threads The most tasks to run at once.
+ *
+ * @throws The error of the first task that failed.
+ */
+void TaskGraph::run(std::size_t threads)
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Task> ready;
+    for (Task task = 0; task < nodes_.size(); ++task)
+    {
+        if (nodes_[task].waiting == 0)
+        {
+            ready.push_back(task);
+        }
+    }
+    std::size_t running = 0;
+    std::size_t finished = 0;
+    std::exception_ptr error = nullptr;
+    auto *metrics = Metrics::current();
+    auto budget = Util::thread_budget();
+
+    auto work = [&]()
+    {
+        Metrics::Scope scope(metrics);
+        Util::set_thread_budget(budget);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            changed.wait(lock, [&]() { return !ready.empty() || error || finished == nodes_.size() || running == 0; });
+            if (error || ready.empty())
+            {
+                return; // failed, done, or nothing left that can become ready
+            }
+
+            auto task = ready.front();
+            ready.pop_front();
+            ++running;
+            lock.unlock();
+
+            auto &node = nodes_[task];
+            std::exception_ptr failure = nullptr;
+            node.start = Clock::now();
+            try
+            {
+                node.fn();
+            }
+            catch (...)
+            {
+                failure = std::current_exception();
+            }
+            node.finish = Clock::now();
+
+            lock.lock();
+            --running;
+            ++finished;
+            node.ran = true;
+            if (failure && !error)
+            {
+                error = failure;
+            }
+            for (auto next : node.next)
+            {
+                if (--nodes_[next].waiting == 0)
+                {
+                    ready.push_back(next);
+                }
+            }
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    auto count = std::min(std::max<std::size_t>(1, threads), std::max<std::size_t>(1, nodes_.size()));
+    for (std::size_t t = 1; t < count; ++t)
+    {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto &thread : pool)
+    {
+        thread.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * The wall-clock time the given tasks took together, from the first starting to the last finishing.
+ * Tasks that did not run are ignored.
+ *
+ * @param tasks The tasks to time.
+ *
+ * @return The time in milliseconds, or 0 if none of the tasks ran.
+ */
+long long TaskGraph::elapsed_ms(std::vector<Task> tasks) const
+{
+    Clock::time_point start = Clock::time_point::max();
+    Clock::time_point finish = Clock::time_point::min();
+    for (auto task : tasks)
+    {
+        if (nodes_[task].ran)
+        {
+            start = std::min(start, nodes_[task].start);
+            finish = std::max(finish, nodes_[task].finish);
+        }
+    }
+    if (start > finish)
+    {
+        return 0;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count();
+}
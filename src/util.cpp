@@ -1,11 +1,30 @@
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
 #include <ctime>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "assignment.h"
+#include "candidates.h"
+#include "cost_matrix.h"
+#include "dispatch.h"
+#include "graph.h"
+#include "metrics.h"
 #include "file_io.h"
 
 namespace Util
@@ -44,20 +63,54 @@ namespace Util
         return oss.str();
     }
 
+    /**
+     * Split the given string at every occurrence of the delimiter.
+     *
+     * @param str The string to split.
+     * @param delim The delimiter.
+     *
+     * @return The pieces of the string between delimiters, including empty ones.
+     */
+    std::vector<std::string> split(std::string str, char delim)
+    {
+        std::vector<std::string> pieces;
+        std::size_t begin = 0;
+        for (auto end = str.find(delim); end != std::string::npos; end = str.find(delim, begin))
+        {
+            pieces.push_back(str.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        pieces.push_back(str.substr(begin));
+        return pieces;
+    }
+
+    const auto DEFAULT_CHECKPOINT_S = "600"; // ten minutes between snapshots of the solver
+
     /**
      * Parse command line arguments.
      * args[0]:  argv[0]
-     * args[1]:  graph G file
-     * args[2]:  graph H file
+     * args[1]:  graph G file, or a directory or list of them
+     * args[2]:  graph H file, or a directory or list of them
      * args[3]:  biological data file
-     * args[4]:  GDV - edge weight balancer
-     * args[5]:  topological - biological balancer
+     * args[4]:  GDV - edge weight balancer, or a comma-separated list of them to sweep
+     * args[5]:  topological - biological balancer, or a comma-separated list of them to sweep
      * args[6]:  G alias
      * args[7]:  H alias
      * args[8]:  B alias
      * args[9]:  do a passthrough?
      * args[10]: include a timestamp?
      * args[11]: include a greekstamp?
+     * args[14]: scratch directory for out-of-core cost matrices
+     * args[15]: write the graphs as binary CSR files?
+     * args[16]: write cost matrices and GDVs as .npy files?
+     * args[17]: quiet; print only errors to the console?
+     * args[18]: verbose; also log debugging details?
+     * args[19]: gzip-compress the CSV outputs?
+     * args[20]: the number of candidates to list per node of G, or 0 for none
+     * args[21]: the memory limit of an alignment, in bytes, or 0 for none
+     * args[22]: the seconds between snapshots of the solver, or 0 for no checkpoints
+     * args[23]: resume from checkpoints?
+     * args[24]: prune the topological costs of pairs that can never be reported?
      *
      * @param argc The number of command line arguments.
      * @param argv The command line arguments.
@@ -68,20 +121,20 @@ namespace Util
      */
     std::vector<std::string> parse_args(int argc, char *argv[])
     {
-        std::vector<std::string> args = {"", "", "", "", "1", "1", "0", "", "", "", "0", "0", "0", "0"};
+        std::vector<std::string> args = {"", "", "", "", "1", "1", "0", "", "", "", "0", "0", "0", "0", "", "0", "0", "0", "0", "0", "0", "0", "0", "0", "0"};
 
-        if (argc < 3 || argc > 14)
+        if (argc < 3 || argc > 25)
         {
             throw std::invalid_argument("Invalid number of arguments.\nUsage: ./minaaa.exe <G.csv> <H.csv> \nSee README.md for additional options and details.");
         }
 
-        if (!FileIO::is_accessible(argv[1]))
+        if (!FileIO::is_accessible(argv[1]) && !FileIO::is_directory(argv[1]))
         {
-            throw std::invalid_argument("The first argument specified must be a readable file.");
+            throw std::invalid_argument("The first argument specified must be a readable file or directory.");
         }
-        if (!FileIO::is_accessible(argv[2]))
+        if (!FileIO::is_accessible(argv[2]) && !FileIO::is_directory(argv[2]))
         {
-            throw std::invalid_argument("The second argument specified must be a readable file.");
+            throw std::invalid_argument("The second argument specified must be a readable file or directory.");
         }
 
         args[0] = argv[0];
@@ -102,17 +155,23 @@ namespace Util
             else if (arg.find("-a=") != std::string::npos)
             {
                 args[4] = arg.substr(3);
-                if (std::stod(args[4]) < 0 || std::stod(args[4]) > 1)
+                for (const auto &alpha : split(args[4], ','))
                 {
-                    throw std::invalid_argument("The alpha argument must be in range [0, 1].");
+                    if (std::stod(alpha) < 0 || std::stod(alpha) > 1)
+                    {
+                        throw std::invalid_argument("The alpha argument must be in range [0, 1].");
+                    }
                 }
             }
             else if (arg.find("-b=") != std::string::npos)
             {
                 args[5] = arg.substr(3);
-                if (std::stod(args[5]) < 0 || std::stod(args[5]) > 1)
+                for (const auto &beta : split(args[5], ','))
                 {
-                    throw std::invalid_argument("The beta argument must be in range [0, 1].");
+                    if (std::stod(beta) < 0 || std::stod(beta) > 1)
+                    {
+                        throw std::invalid_argument("The beta argument must be in range [0, 1].");
+                    }
                 }
             }
             else if (arg.find("-st=") != std::string::npos)
@@ -147,6 +206,77 @@ namespace Util
                     throw std::invalid_argument("The B alias contains an illegal character.");
                 }
             }
+            else if (arg.find("-scratch=") != std::string::npos)
+            {
+                args[14] = arg.substr(9);
+                if (!FileIO::is_directory(args[14]))
+                {
+                    throw std::invalid_argument("The scratch directory does not exist.");
+                }
+            }
+            else if (arg.find("-k=") != std::string::npos)
+            {
+                args[20] = arg.substr(3);
+                if (args[20].empty() || args[20].find_first_not_of("0123456789") != std::string::npos || std::stoul(args[20]) < 1)
+                {
+                    throw std::invalid_argument("The k argument must be a positive integer.");
+                }
+            }
+            else if (arg.find("-mem-limit=") != std::string::npos)
+            {
+                // A number of bytes, optionally with a binary suffix, stored as the number of bytes
+                const std::string SUFFIXES = "KMGT";
+                auto limit = arg.substr(11);
+                auto end = limit.find_first_not_of("0123456789");
+                auto suffix = (end == std::string::npos) ? std::string::npos : SUFFIXES.find(std::toupper(limit[end]));
+                if (end == 0 || (end != std::string::npos && (suffix == std::string::npos || end + 1 != limit.size())) ||
+                    std::stoull(limit.substr(0, end)) == 0)
+                {
+                    throw std::invalid_argument("The memory limit must be a positive number of bytes, optionally suffixed with K, M, G or T.");
+                }
+                auto shift = (suffix == std::string::npos) ? 0 : 10 * (suffix + 1);
+                args[21] = std::to_string(std::stoull(limit.substr(0, end)) << shift);
+            }
+            else if (arg.find("-checkpoint") != std::string::npos)
+            {
+                if (arg != "-checkpoint" && arg.find("-checkpoint=") != 0)
+                {
+                    throw std::invalid_argument("Invalid argument: " + arg);
+                }
+                args[22] = (arg == "-checkpoint") ? DEFAULT_CHECKPOINT_S : arg.substr(12);
+                if (args[22].empty() || args[22].find_first_not_of("0123456789") != std::string::npos || std::stoul(args[22]) < 1)
+                {
+                    throw std::invalid_argument("The checkpoint interval must be a positive number of seconds.");
+                }
+            }
+            else if (arg == "-resume")
+            {
+                args[23] = "1";
+            }
+            else if (arg == "-prune")
+            {
+                args[24] = "1";
+            }
+            else if (arg == "-z")
+            {
+                args[19] = "1";
+            }
+            else if (arg == "-q")
+            {
+                args[17] = "1";
+            }
+            else if (arg == "-v")
+            {
+                args[18] = "1";
+            }
+            else if (arg == "-npy")
+            {
+                args[16] = "1";
+            }
+            else if (arg == "-csr")
+            {
+                args[15] = "1";
+            }
             else if (arg.find("-p") != std::string::npos)
             {
                 args[10] = "1";
@@ -169,158 +299,596 @@ namespace Util
             }
         }
 
+        if (args[23] == "1" && args[22] == "0")
+        {
+            args[22] = DEFAULT_CHECKPOINT_S; // a resumed run keeps checkpointing, in case it is cut short again
+        }
+
+        auto is_sweep = (args[4].find(',') != std::string::npos || args[5].find(',') != std::string::npos);
+        if (is_sweep && (FileIO::is_network_set(args[1]) || FileIO::is_network_set(args[2])))
+        {
+            throw std::invalid_argument("Alpha and beta can only be swept when aligning a single pair of networks.");
+        }
+        if (args[7] != "" && FileIO::is_network_set(args[1]))
+        {
+            throw std::invalid_argument("The G alias cannot be given when aligning a set of networks.");
+        }
+        if (args[8] != "" && FileIO::is_network_set(args[2]))
+        {
+            throw std::invalid_argument("The H alias cannot be given when aligning to a set of networks.");
+        }
+
         return args;
     }
 
     /**
-     * Parse the given double matrix into a binary matrix.
+     * Parse the command line arguments of a server, checking that they are properly formatted.
+     * args[0]: the program name
+     * args[1]: the path of the socket to listen on
+     * args[2]: the most networks to keep between requests
+     *
+     * @param argc The number of command line arguments.
+     * @param argv The command line arguments.
      *
-     * @param double_matrix The matrix to convert to binary.
+     * @return A list with values for all server arguments, in a certain order.
      *
-     * @return A binary matrix.
+     * @throws std::invalid_argument if an argument is misformatted.
      */
-    std::vector<std::vector<unsigned>> binarify(std::vector<std::vector<double>> double_matrix)
+    std::vector<std::string> parse_serve_args(int argc, char *argv[])
     {
-        std::vector<std::vector<unsigned>> binary_matrix;
-        for (unsigned i = 0; i < double_matrix.size(); ++i)
+        std::vector<std::string> args = {argv[0], "", "16"};
+
+        for (auto i = 1; i < argc; ++i)
         {
-            std::vector<unsigned> row;
-            for (unsigned j = 0; j < double_matrix[i].size(); ++j)
+            std::string arg = std::string(argv[i]);
+            if (arg.find("-serve=") == 0)
             {
-                if (double_matrix[i][j] != 0)
+                args[1] = arg.substr(7);
+                if (args[1].empty())
                 {
-                    row.push_back(1);
+                    throw std::invalid_argument("The socket path cannot be empty.");
                 }
-                else
+            }
+            else if (arg.find("-cache=") == 0)
+            {
+                args[2] = arg.substr(7);
+                if (args[2].empty() || args[2].find_first_not_of("0123456789") != std::string::npos || std::stoul(args[2]) < 1)
                 {
-                    row.push_back(0);
+                    throw std::invalid_argument("The cache argument must be a positive integer.");
                 }
             }
-            binary_matrix.push_back(row);
+            else
+            {
+                throw std::invalid_argument("Invalid argument: " + arg + "\nUsage: ./minaa.exe -serve=<socket> [-cache=n]");
+            }
         }
 
-        return binary_matrix;
+        return args;
     }
 
     /**
-     * Normalize the entries of the given matrix to be in range [0, 1].
+     * The degree of every node in the given graph, as seen by GraphCrunch: the graph is the
+     * undirected closure of the upper triangle of its adjacency matrix, without self-loops.
      *
-     * @param matrix The matrix to normalize.
+     * @param graph The graph.
      *
-     * @return The normalized matrix.
+     * @return The degree of each node.
      */
-    std::vector<std::vector<double>> normalize(std::vector<std::vector<double>> matrix)
+    std::vector<unsigned> degrees(const Graph &graph)
     {
-        // Find the max and min values in the matrix
-        double min = std::numeric_limits<double>::max();
-        double max = std::numeric_limits<double>::min();
-        for (unsigned i = 0; i < matrix.size(); ++i)
+        std::vector<unsigned> degs(graph.size(), 0);
+        for (unsigned i = 0; i < graph.size(); ++i)
         {
-            for (unsigned j = 0; j < matrix[i].size(); ++j)
+            for (auto k = graph.offsets[i]; k < graph.offsets[i + 1]; ++k)
             {
-                if (matrix[i][j] < min)
-                {
-                    min = matrix[i][j];
-                }
-                if (matrix[i][j] > max)
+                auto j = graph.neighbors[k];
+                if (j > i && j < graph.size())
                 {
-                    max = matrix[i][j];
+                    ++degs[i];
+                    ++degs[j];
                 }
             }
         }
 
-        // Make all values non-negative
-        if (min < 0)
+        return degs;
+    }
+
+    /*
+     * The most threads that parallel work started on this thread may use, or 0 for all the hardware threads.
+     * The threads that parallel_for and TaskGraph start take on the budget of the thread that started them.
+     */
+    thread_local std::size_t threads_allowed = 0;
+
+    /**
+     * The number of threads that parallel work started on this thread may use: every hardware thread,
+     * unless the work is one of several that share them, such as concurrent alignments.
+     *
+     * @return The number of threads, at least 1.
+     */
+    std::size_t thread_budget()
+    {
+        return std::max<std::size_t>(1, threads_allowed > 0 ? threads_allowed : std::thread::hardware_concurrency());
+    }
+
+    /**
+     * Limit the parallel work started on this thread, and on the threads it starts, to the given number of threads.
+     *
+     * @param threads The number of threads, or 0 for all the hardware threads.
+     */
+    void set_thread_budget(std::size_t threads)
+    {
+        threads_allowed = threads;
+    }
+
+    /**
+     * Run fn over [0, n) in blocks of consecutive indices, spread over the thread budget of the calling thread.
+     * Blocks are handed out dynamically, so uneven blocks still balance.
+     *
+     * @param n The number of indices.
+     * @param block The number of consecutive indices given to fn at once.
+     * @param fn The function to run, given the beginning and end of a block.
+     *
+     * @throws The first exception thrown by fn, once every thread has stopped.
+     */
+    void parallel_for(std::size_t n, std::size_t block, const std::function<void(std::size_t, std::size_t)> &fn)
+    {
+        block = std::max<std::size_t>(1, block);
+        std::size_t blocks = (n + block - 1) / block;
+        std::size_t threads = std::min(thread_budget(), blocks);
+        auto inherited = threads_allowed;
+
+        std::atomic<std::size_t> next(0);
+        std::exception_ptr error = nullptr;
+        std::mutex error_mutex;
+        auto *metrics = Metrics::current();
+        auto work = [&]()
         {
-            // Shift all values up by the min value
-            for (unsigned i = 0; i < matrix.size(); ++i)
+            Metrics::Scope scope(metrics);
+            threads_allowed = inherited;
+            for (auto b = next.fetch_add(block); b < n; b = next.fetch_add(block))
             {
-                for (unsigned j = 0; j < matrix[i].size(); ++j)
+                try
                 {
-                    matrix[i][j] += std::abs(min);
+                    fn(b, std::min(n, b + block));
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                    next = n; // stop handing out blocks
                 }
             }
-            max += std::abs(min);
-            min = 0;
+        };
+
+        std::vector<std::thread> pool;
+        for (std::size_t t = 1; t < threads; ++t)
+        {
+            pool.emplace_back(work);
+        }
+        work();
+        for (auto &thread : pool)
+        {
+            thread.join();
         }
 
-        // Rescale such that max is 1
-        std::vector<std::vector<double>> norm_matrix;
-        for (unsigned i = 0; i < matrix.size(); ++i)
+        if (error)
         {
-            std::vector<double> row;
-            for (unsigned j = 0; j < matrix[i].size(); ++j)
-            {
-                row.push_back(matrix[i][j] / max);
-            }
-            norm_matrix.push_back(row);
+            std::rethrow_exception(error);
         }
+    }
 
-        return norm_matrix;
+    /**
+     * The amount of physical memory in the machine.
+     *
+     * @return The number of bytes of physical memory, or 0 if it is unknown.
+     */
+    std::size_t physical_memory()
+    {
+        #ifndef _WIN32 // Unix
+        auto pages = sysconf(_SC_PHYS_PAGES);
+        auto page = sysconf(_SC_PAGE_SIZE);
+        if (pages > 0 && page > 0)
+        {
+            return static_cast<std::size_t>(pages) * static_cast<std::size_t>(page);
+        }
+        #endif
+        return 0;
     }
 
     /**
-     * Set all entries in the given matrix to 1 - value.
+     * The net cost of an alignment, as reported in the alignment list: the sum of (1 - similarity) over
+     * the aligned pairs whose similarity is above the threshold.
      *
-     * @param matrix The matrix to update each entry of.
+     * @param alignment The alignment.
+     * @param similarity_threshold The similarity threshold above which aligned pairs are counted.
      *
-     * @return The updated matrix.
+     * @return The net cost of the alignment.
      */
-    std::vector<std::vector<double>> one_minus(std::vector<std::vector<double>> matrix)
+    double net_cost(const Assignment &alignment, double similarity_threshold)
     {
-        std::vector<std::vector<double>> one_minus_matrix;
-        for (unsigned i = 0; i < matrix.size(); ++i)
+        double cost = 0;
+        for (std::size_t i = 0; i < alignment.rows; ++i)
         {
-            std::vector<double> row;
-            for (unsigned j = 0; j < matrix[i].size(); ++j)
+            if (alignment.match[i] != Assignment::NONE && alignment.similarity[i] > similarity_threshold)
             {
-                row.push_back(1 - matrix[i][j]);
+                cost += (1 - alignment.similarity[i]);
             }
-            one_minus_matrix.push_back(row);
         }
+        return cost;
+    }
+
+    /*
+     * The number of rows of the matrix to give each thread at once: whole tiles, or smaller
+     * bands when the matrix is only a few tiles, so that every thread still gets work.
+     */
+    std::size_t band_rows(const CostMatrix &matrix)
+    {
+        return std::min(matrix.tile_rows(), std::max<std::size_t>(1, matrix.rows() / 64));
+    }
+
+    /*
+     * Lower min and raise max to the extremes of the n values of row.
+     * The extremes are taken in independent lanes so that they vectorize.
+     */
+    DISPATCH void min_max(const double *row, std::size_t n, double &min, double &max)
+    {
+        const unsigned LANES = 8;
+        double lo[LANES];
+        double hi[LANES];
+        std::fill(lo, lo + LANES, min);
+        std::fill(hi, hi + LANES, max);
+
+        std::size_t j = 0;
+        for (; j + LANES <= n; j += LANES)
+        {
+            for (unsigned l = 0; l < LANES; ++l)
+            {
+                lo[l] = std::min(lo[l], row[j + l]);
+                hi[l] = std::max(hi[l], row[j + l]);
+            }
+        }
+        for (; j < n; ++j)
+        {
+            lo[0] = std::min(lo[0], row[j]);
+            hi[0] = std::max(hi[0], row[j]);
+        }
+
+        min = *std::min_element(lo, lo + LANES);
+        max = *std::max_element(hi, hi + LANES);
+    }
+
+    /*
+     * Transform each of the n values of row in place: shift then divide to normalize, optionally replace
+     * with 1 - value, then, if top is given, weigh top by beta and the value by 1 - beta.
+     *
+     * Returns whether every result is a valid cost, in range [0, 1], or NaN where top was pruned.
+     */
+    DISPATCH bool transform_row(double *row, const double *top, std::size_t n, double shift, double max, bool invert, double beta)
+    {
+        bool valid = true;
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            double x = (row[j] + shift) / max;
+            if (invert)
+            {
+                x = 1 - x;
+            }
+            if (top != nullptr)
+            {
+                x = beta * top[j] + (1 - beta) * x;
+            }
+            row[j] = x;
+            valid &= (x >= 0 && x <= 1) || (top != nullptr && std::isnan(top[j]));
+        }
+        return valid;
+    }
+
+    /*
+     * The shift and divisor that normalize values with the given min and max to range [0, 1].
+     */
+    void shift_extremes(double min, double &max, double &shift)
+    {
+        // Make all values non-negative, by shifting all values up by the min value
+        shift = 0;
+        if (min < 0)
+        {
+            shift = std::abs(min);
+            max += std::abs(min);
+        }
+    }
+
+    /*
+     * The shift and divisor that normalize the entries of the given matrix to range [0, 1].
+     */
+    void normalization(const CostMatrix &matrix, double &shift, double &max)
+    {
+        // Find the max and min values in the matrix
+        double min = std::numeric_limits<double>::max();
+        max = std::numeric_limits<double>::min();
+        std::mutex extremes_mutex;
+        parallel_for(matrix.rows(), band_rows(matrix),
+                     [&](std::size_t begin, std::size_t end)
+                     {
+                         double lo = std::numeric_limits<double>::max();
+                         double hi = std::numeric_limits<double>::min();
+                         for (auto i = begin; i < end; ++i)
+                         {
+                             min_max(matrix[i], matrix.cols(), lo, hi);
+                         }
+                         matrix.release(begin, end);
+
+                         std::lock_guard<std::mutex> lock(extremes_mutex);
+                         min = std::min(min, lo);
+                         max = std::max(max, hi);
+                     });
+
+        shift_extremes(min, max, shift);
+    }
+
+    /*
+     * Apply transform_row to every row of the matrix, in parallel.
+     */
+    void transform(CostMatrix &matrix, const CostMatrix *top, double shift, double max, bool invert, double beta)
+    {
+        parallel_for(matrix.rows(), band_rows(matrix),
+                     [&](std::size_t begin, std::size_t end)
+                     {
+                         bool valid = true;
+                         for (auto i = begin; i < end; ++i)
+                         {
+                             valid &= transform_row(matrix[i], (top != nullptr) ? (*top)[i] : nullptr, matrix.cols(), shift, max, invert, beta);
+                         }
+                         matrix.release(begin, end);
+                         if (top != nullptr)
+                         {
+                             top->release(begin, end);
+                         }
+                         if (!valid)
+                         {
+                             throw std::runtime_error("The cost matrix contains values outside of range [0, 1].");
+                         }
+                     });
+    }
+
+    /**
+     * Normalize the entries of the given matrix to be in range [0, 1], in place.
+     *
+     * @param matrix The matrix to normalize.
+     * @param do_one_minus Whether to also replace each normalized entry with 1 - value.
+     *
+     * @throws std::runtime_error If the matrix contains values that cannot be normalized.
+     */
+    void normalize(CostMatrix &matrix, bool do_one_minus)
+    {
+        double shift;
+        double max;
+        normalization(matrix, shift, max);
+        transform(matrix, nullptr, shift, max, do_one_minus, 1);
+    }
 
-        return one_minus_matrix;
+    /**
+     * Set all entries in the given matrix to 1 - value, in place.
+     *
+     * @param matrix The matrix to update each entry of.
+     *
+     * @throws std::runtime_error If the matrix contains values outside of range [0, 1].
+     */
+    void one_minus(CostMatrix &matrix)
+    {
+        transform(matrix, nullptr, 0, 1, true, 1);
     }
 
     /**
-     * Combine the topological and biological cost matrices.
+     * Combine the topological and biological cost matrices, in place of the biological one.
+     * Normalizing, converting and blending the biological matrix is done in a single pass, which also
+     * checks that every combined cost is in range [0, 1].
      *
      * @param topological_costs The topological cost matrix.
-     * @param biological_costs The biological cost matrix.
+     * @param biological_costs The biological cost matrix, replaced by the combined cost matrix.
      * @param beta of the weight goes to topological similarity, (1 - beta) goes to biological similarity.
+     * @param do_normalize Whether to normalize the biological matrix first.
+     * @param do_one_minus Whether to convert the (normalized) biological similarities to costs first.
      *
-     * @return The combined cost matrix.
-     *
-     * @throws
+     * @throws std::runtime_error If the matrices differ in shape, or a combined cost is outside of range [0, 1].
      */
-    std::vector<std::vector<double>> combine(
-        std::vector<std::vector<double>> topological_costs, std::vector<std::vector<double>> biological_costs, double beta)
+    void combine(const CostMatrix &topological_costs, CostMatrix &biological_costs, double beta, bool do_normalize, bool do_one_minus)
     {
         // Handle absent biological costs
         if (biological_costs.empty())
         {
-            return topological_costs;
+            biological_costs = CostMatrix(topological_costs.rows(), topological_costs.cols());
+            beta = 1;
+            do_normalize = false;
+            do_one_minus = false;
         }
         // Handle invalid beta
         if (beta < 0 || beta > 1)
         {
             std::cerr << "Beta must be between 0 and 1. Defaulting to beta = 1." << std::endl;
-            return topological_costs;
+            beta = 1;
+        }
+        if (biological_costs.rows() != topological_costs.rows() || biological_costs.cols() != topological_costs.cols())
+        {
+            throw std::runtime_error("The biological matrix must have a row for each node of G and a column for each node of H.");
+        }
+
+        double shift = 0;
+        double max = 1;
+        if (do_normalize)
+        {
+            normalization(biological_costs, shift, max);
         }
+        transform(biological_costs, &topological_costs, shift, max, do_one_minus, beta);
+    }
 
-        std::vector<std::vector<double>> overall_costs;
 
-        for (unsigned i = 0; i < topological_costs.size(); ++i)
+    /**
+     * Blend the topological costs with normalized biological costs into a new overall cost matrix,
+     * leaving both inputs as they are, so that they can be blended again with another beta.
+     * The result is the same as combining the unnormalized biological costs in place.
+     *
+     * @param topological_costs The topological cost matrix, which is not read if beta is 0.
+     * @param biological_costs The normalized biological cost matrix.
+     * @param beta of the weight goes to topological similarity, (1 - beta) goes to biological similarity.
+     * @param scratch_dir If nonempty, the directory in which to store the result out of core.
+     *
+     * @return The overall cost matrix.
+     *
+     * @throws std::runtime_error If the matrices differ in shape, or a blended cost is outside of range [0, 1].
+     */
+    CostMatrix blend(const CostMatrix &topological_costs, const CostMatrix &biological_costs, double beta, std::string scratch_dir)
+    {
+        if (beta != 0 && (biological_costs.rows() != topological_costs.rows() || biological_costs.cols() != topological_costs.cols()))
         {
-            std::vector<double> row;
-            for (unsigned j = 0; j < topological_costs[i].size(); ++j)
-            {
-                row.push_back(beta * topological_costs[i][j] + (1 - beta) * biological_costs[i][j]);
-            }
-            overall_costs.push_back(row);
+            throw std::runtime_error("The biological matrix must have a row for each node of G and a column for each node of H.");
         }
 
+        CostMatrix overall_costs(biological_costs.rows(), biological_costs.cols(), 0, scratch_dir);
+        parallel_for(overall_costs.rows(), band_rows(overall_costs),
+                     [&](std::size_t begin, std::size_t end)
+                     {
+                         bool valid = true;
+                         for (auto i = begin; i < end; ++i)
+                         {
+                             std::copy(biological_costs[i], biological_costs[i] + overall_costs.cols(), overall_costs[i]);
+                             if (beta != 0)
+                             {
+                                 valid &= transform_row(overall_costs[i], topological_costs[i], overall_costs.cols(), 0, 1, false, beta);
+                             }
+                         }
+                         overall_costs.release(begin, end);
+                         biological_costs.release(begin, end);
+                         if (beta != 0)
+                         {
+                             topological_costs.release(begin, end);
+                         }
+                         if (!valid)
+                         {
+                             throw std::runtime_error("The cost matrix contains values outside of range [0, 1].");
+                         }
+                     });
         return overall_costs;
     }
 
+    /**
+     * Combine the topological costs with a biological matrix streamed from file, in place of the
+     * topological costs, so that the biological matrix is never held whole.
+     * The file is read twice: once to find the extremes that normalize it, then again to normalize,
+     * convert and blend each band of rows straight into the topological matrix, which is released tile by
+     * tile when it is out of core.
+     *
+     * @param topological_costs The topological cost matrix, replaced by the combined cost matrix.
+     * @param bio_file The biological matrix file, as accepted by FileIO::file_to_cost_matrix.
+     * @param scratch_dir If nonempty, the directory in which a triplet file's matrix is stored out of core.
+     * @param g_labels The labels of G, which index the rows.
+     * @param h_labels The labels of H, which index the columns.
+     * @param beta of the weight goes to topological similarity, (1 - beta) goes to biological similarity.
+     * @param do_one_minus Whether the biological values are similarities, to convert to costs once normalized.
+     *
+     * @throws std::runtime_error If the file could not be read, or a combined cost is outside of range [0, 1].
+     */
+    void combine_streamed(CostMatrix &topological_costs, std::string bio_file, std::string scratch_dir,
+                          const std::vector<std::string> &g_labels, const std::vector<std::string> &h_labels,
+                          double beta, bool do_one_minus)
+    {
+        // Handle invalid beta
+        if (beta < 0 || beta > 1)
+        {
+            std::cerr << "Beta must be between 0 and 1. Defaulting to beta = 1." << std::endl;
+            beta = 1;
+        }
+        auto cols = topological_costs.cols();
+
+        // First pass: the extremes of the biological values
+        double min = std::numeric_limits<double>::max();
+        double max = std::numeric_limits<double>::min();
+        std::mutex extremes_mutex;
+        FileIO::scan_cost_matrix(bio_file, scratch_dir, g_labels, h_labels, do_one_minus,
+                                 [&](std::size_t begin, std::size_t end, double *rows)
+                                 {
+                                     double lo = std::numeric_limits<double>::max();
+                                     double hi = std::numeric_limits<double>::min();
+                                     min_max(rows, (end - begin) * cols, lo, hi);
+
+                                     std::lock_guard<std::mutex> lock(extremes_mutex);
+                                     min = std::min(min, lo);
+                                     max = std::max(max, hi);
+                                 });
+        double shift;
+        shift_extremes(min, max, shift);
+
+        // Second pass: normalize, convert and blend each band into the topological matrix
+        FileIO::scan_cost_matrix(bio_file, scratch_dir, g_labels, h_labels, do_one_minus,
+                                 [&](std::size_t begin, std::size_t end, double *rows)
+                                 {
+                                     bool valid = true;
+                                     for (auto i = begin; i < end; ++i)
+                                     {
+                                         auto *row = rows + (i - begin) * cols;
+                                         valid &= transform_row(row, topological_costs[i], cols, shift, max, do_one_minus, beta);
+                                         std::copy(row, row + cols, topological_costs[i]);
+                                     }
+                                     topological_costs.release(begin, end);
+                                     if (!valid)
+                                     {
+                                         throw std::runtime_error("The cost matrix contains values outside of range [0, 1].");
+                                     }
+                                 });
+    }
+
+
+    /**
+     * Select the k least costly nodes of H for each node of G, in parallel, with a linear-time selection
+     * per row followed by sorting only the k selected. Ties are broken by the lower index in H, so the
+     * result does not depend on the selection order. Pruned pairs, whose cost is NaN, come last.
+     *
+     * @param matrix The |G| x |H| cost matrix.
+     * @param k The number of candidates per node of G, capped at |H|.
+     *
+     * @return The candidates of each node of G, best first.
+     */
+    Candidates top_k(const CostMatrix &matrix, std::size_t k)
+    {
+        Candidates candidates;
+        candidates.rows = matrix.rows();
+        candidates.k = std::min(k, matrix.cols());
+        candidates.match.resize(candidates.rows * candidates.k);
+        candidates.cost.resize(candidates.rows * candidates.k);
+        if (candidates.k == 0)
+        {
+            return candidates;
+        }
+
+        parallel_for(matrix.rows(), band_rows(matrix),
+                     [&](std::size_t begin, std::size_t end)
+                     {
+                         std::vector<std::pair<double, std::size_t>> row(matrix.cols());
+                         for (auto i = begin; i < end; ++i)
+                         {
+                             for (std::size_t j = 0; j < matrix.cols(); ++j)
+                             {
+                                 row[j] = {std::isnan(matrix[i][j]) ? std::numeric_limits<double>::infinity() : matrix[i][j], j};
+                             }
+                             auto kth = row.begin() + candidates.k;
+                             if (kth != row.end())
+                             {
+                                 std::nth_element(row.begin(), kth, row.end());
+                             }
+                             std::sort(row.begin(), kth);
+
+                             for (std::size_t r = 0; r < candidates.k; ++r)
+                             {
+                                 candidates.match[i * candidates.k + r] = row[r].second;
+                                 candidates.cost[i * candidates.k + r] = matrix[i][row[r].second];
+                             }
+                         }
+                         matrix.release(begin, end);
+                     });
+
+        return candidates;
+    }
+
 }
@@ -0,0 +1,1458 @@
+// test_minaa.cpp
+// Behavior Tests
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "assignment.h"
+#include "async_writer.h"
+#include "candidates.h"
+#include "checkpoint.h"
+#include "cost_matrix.h"
+#include "graph.h"
+#include "libminaa.h"
+#include "logger.h"
+#include "metrics.h"
+#include "network_cache.h"
+#include "task_graph.h"
+#include "network.h"
+#include "settings.h"
+#include "pipeline.h"
+#include "generators.h"
+#include "server.h"
+#include "hungarian.h"
+#include "gdvs_dist.h"
+#include "graphcrunch.h"
+#include "file_io.h"
+#include "util.h"
+
+namespace
+{
+    const std::string EXAMPLES = "examples/"; // relative to the repository root, where make test runs
+    const double EPSILON = 1e-12;
+
+    int failures = 0;
+    std::string scratch; // a directory of its own for the files each test writes
+
+    /*
+     * Report a failed check of the running test.
+     */
+    void check(bool condition, std::string what)
+    {
+        if (!condition)
+        {
+            std::cerr << "  FAILED: " << what << std::endl;
+            ++failures;
+        }
+    }
+
+    /*
+     * Whether the given call throws an exception of type E.
+     */
+    template <typename E>
+    bool throws(const std::function<void()> &call)
+    {
+        try
+        {
+            call();
+        }
+        catch (E &)
+        {
+            return true;
+        }
+        catch (...)
+        {
+        }
+        return false;
+    }
+
+    std::string read_file(std::string filepath)
+    {
+        std::ifstream fin(filepath, std::ios::binary);
+        std::stringstream text;
+        text << fin.rdbuf();
+        return text.str();
+    }
+
+    /*
+     * The settings of the given command line, as the program parses it, writing into the scratch directory.
+     */
+    Settings settings(std::vector<std::string> args)
+    {
+        args.insert(args.begin(), "minaa.exe");
+        std::vector<char *> argv;
+        for (auto &arg : args)
+        {
+            argv.push_back(arg.data());
+        }
+        auto settings = Pipeline::settings(Util::parse_args(argv.size(), argv.data()), "");
+        settings.base_path = scratch + "alignments";
+        settings.do_timestamp = false;
+        settings.is_quiet = true;
+        return settings;
+    }
+
+    /*
+     * Align network G (by default the example one), under the given alias, to the example network H with
+     * the given options, as the program would, into the directory alignments/<alias>-h of the scratch directory.
+     */
+    Assignment align(std::string alias, std::vector<std::string> options, std::string g_file = EXAMPLES + "g.csv")
+    {
+        options.insert(options.begin(), {g_file, EXAMPLES + "h.csv"});
+        auto g = Pipeline::network(g_file, alias);
+        auto h = Pipeline::network(EXAMPLES + "h.csv", "");
+        Logger log;
+        return Pipeline::align(settings(options), g, h, log);
+    }
+
+    /*
+     * A cost matrix with the given rows.
+     */
+    CostMatrix matrix(const std::vector<std::vector<double>> &values)
+    {
+        CostMatrix matrix(values.size(), values.empty() ? 0 : values[0].size());
+        for (std::size_t i = 0; i < matrix.rows(); ++i)
+        {
+            std::copy(values[i].begin(), values[i].end(), matrix[i]);
+        }
+        return matrix;
+    }
+
+    void test_pruning_keeps_exact_costs()
+    {
+        auto g_gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(EXAMPLES + "g.csv", false));
+        auto h_gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(EXAMPLES + "h.csv", false));
+        const double CUTOFF = 0.7;
+        auto full = GDVs_Dist::gdvs_dist(g_gdvs, h_gdvs, 0.6, 1, "");
+        auto pruned = GDVs_Dist::gdvs_dist(g_gdvs, h_gdvs, 0.6, CUTOFF, "");
+
+        std::size_t count = 0;
+        auto is_exact = true;
+        for (std::size_t i = 0; i < full.rows(); ++i)
+        {
+            for (std::size_t j = 0; j < full.cols(); ++j)
+            {
+                if (std::isnan(pruned[i][j]))
+                {
+                    ++count;
+                    is_exact &= (full[i][j] > CUTOFF);
+                }
+                else
+                {
+                    is_exact &= (std::abs(pruned[i][j] - full[i][j]) < EPSILON);
+                }
+            }
+        }
+        check(count > 0, "some pairs are pruned");
+        check(is_exact, "only pairs over the cutoff are pruned, and the rest keep their exact cost");
+    }
+
+    void test_pruning_is_opt_in()
+    {
+        MiNAA::Options options;
+        options.beta = 0.8;
+        options.similarity_threshold = 0.5;
+        check(MiNAA::stages(options, true).cutoff == 1, "a threshold alone prunes nothing");
+
+        options.do_prune = true;
+        check(std::abs(MiNAA::stages(options, true).cutoff - 0.5 / 0.8) < EPSILON, "the cutoff is scaled by beta when biological costs are blended");
+        check(MiNAA::stages(options, false).cutoff == 0.5, "the cutoff is 1 - threshold without biological costs");
+        options.beta = 0.5;
+        check(MiNAA::stages(options, true).cutoff == 1, "nothing is pruned once the scaled cutoff reaches 1");
+
+        // Solving a pruned pair at the maximal cost can change the assignment of pairs that are kept
+        auto exact = Hungarian::hungarian(matrix({{0.2, 0.69}, {0.4, 0.8}}), "", false);
+        auto pruned = Hungarian::hungarian(matrix({{0.2, 0.69}, {0.4, std::nan("")}}), "", false);
+        check(exact.match == std::vector<std::size_t>{0, 1}, "the solver finds the optimal assignment");
+        check(pruned.match == std::vector<std::size_t>{1, 0}, "the solver treats a pruned pair as maximally costly");
+    }
+
+    void test_threshold_keeps_the_alignment()
+    {
+        auto with_threshold = align("st", {"-a=0.6", "-st=0.3"});
+        auto without = align("none", {"-a=0.6"});
+        check(with_threshold.match == without.match && with_threshold.similarity == without.similarity,
+              "a threshold without -prune aligns exactly as without a threshold");
+        auto top = read_file(scratch + "alignments/st-h/topological_costs.csv");
+        check(top == read_file(scratch + "alignments/none-h/topological_costs.csv"), "a threshold without -prune writes every cost");
+    }
+
+    void test_pruning_from_the_command_line()
+    {
+        auto pruned = align("pruned", {"-a=0.6", "-st=0.3", "-prune"});
+        auto top = read_file(scratch + "alignments/pruned-h/topological_costs.csv");
+        check(top.find(",NA") != std::string::npos && top.find("nan") == std::string::npos, "pruned pairs are written as NA");
+        auto metrics = read_file(scratch + "alignments/pruned-h/metrics.json");
+        check(metrics.find("\"pruned_pairs\": 0") == std::string::npos, "pruned pairs are counted apart from evaluated ones");
+
+        // Every pair that is reported keeps its exact similarity
+        auto g_gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(EXAMPLES + "g.csv", false));
+        auto h_gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(EXAMPLES + "h.csv", false));
+        auto costs = GDVs_Dist::gdvs_dist(g_gdvs, h_gdvs, 0.6, 1, "");
+        std::size_t reported = 0;
+        auto is_exact = true;
+        for (std::size_t i = 0; i < pruned.rows; ++i)
+        {
+            auto j = pruned.match[i];
+            if (j != Assignment::NONE && pruned.similarity[i] > 0.3)
+            {
+                ++reported;
+                is_exact &= std::abs(pruned.similarity[i] - (1 - costs[i][j])) < EPSILON;
+            }
+        }
+        check(reported > 0, "some pairs are reported");
+        check(is_exact, "every reported pair has its unpruned similarity");
+
+        // The regression of a threshold dropping reportable pairs once biological costs were blended
+        auto bio = "-B=" + EXAMPLES + "bio.csv";
+        auto with_bio = align("bio", {bio, "-b=0.5", "-st=0.5", "-s", "-prune"});
+        auto without_bio = align("bio_none", {bio, "-b=0.5", "-s"});
+        check(with_bio.match == without_bio.match, "-prune with -B and -b aligns as without it when nothing can be pruned");
+        check(std::abs(Util::net_cost(with_bio, 0.5) - Util::net_cost(without_bio, 0.5)) < EPSILON, "-prune with -B and -b reports the same net cost");
+    }
+
+    void test_cost_matrix_store()
+    {
+        CostMatrix heap(3, 4, 0.5);
+        check(!heap.is_mapped() && heap[2][3] == 0.5, "a matrix without a scratch directory is held in memory, filled");
+        check(reinterpret_cast<std::uintptr_t>(heap[0]) % 64 == 0, "a matrix is aligned to a cache line");
+
+        // A matrix that spans many pages, written, released and read back through its scratch file
+        const std::size_t ROWS = 300, COLS = 1000;
+        CostMatrix mapped(ROWS, COLS, 1, scratch);
+        check(mapped.is_mapped() && mapped[ROWS - 1][COLS - 1] == 1, "a matrix in a scratch directory is mapped, filled");
+        check(std::filesystem::is_empty(scratch), "the scratch file is unlinked as soon as it is mapped");
+        for (std::size_t i = 0; i < ROWS; ++i)
+        {
+            for (std::size_t j = 0; j < COLS; ++j)
+            {
+                mapped[i][j] = i + j / 1000.0;
+            }
+        }
+        mapped.release(0, ROWS);
+        auto is_kept = true;
+        for (std::size_t i = 0; i < ROWS; ++i)
+        {
+            for (std::size_t j = 0; j < COLS; ++j)
+            {
+                is_kept &= (mapped[i][j] == i + j / 1000.0);
+            }
+        }
+        check(is_kept, "released rows read back as written");
+
+        auto moved = std::move(mapped);
+        check(mapped.empty() && moved.is_mapped() && moved[1][2] == 1 + 2 / 1000.0, "a moved matrix takes over the mapping");
+
+        // An alignment with its cost matrices out of core is the same as one in memory
+        auto in_core = align("in_core", {"-a=0.6"});
+        auto out_of_core = align("out_of_core", {"-a=0.6", "-scratch=" + scratch});
+        check(in_core.match == out_of_core.match && in_core.similarity == out_of_core.similarity, "-scratch= does not change the alignment");
+        check(read_file(scratch + "alignments/in_core-h/topological_costs.csv") == read_file(scratch + "alignments/out_of_core-h/topological_costs.csv"),
+              "-scratch= does not change the costs written");
+    }
+
+    /*
+     * Whether the matrix holds the given rows, to within EPSILON.
+     */
+    bool same_values(const CostMatrix &matrix, const std::vector<std::vector<double>> &values)
+    {
+        auto is_same = matrix.rows() == values.size();
+        for (std::size_t i = 0; is_same && i < matrix.rows(); ++i)
+        {
+            is_same &= matrix.cols() == values[i].size();
+            for (std::size_t j = 0; is_same && j < matrix.cols(); ++j)
+            {
+                is_same &= std::abs(matrix[i][j] - values[i][j]) < EPSILON;
+            }
+        }
+        return is_same;
+    }
+
+    void test_fused_matrix_pipeline()
+    {
+        auto costs = matrix({{-2, 0}, {1, 2}});
+        Util::normalize(costs, false);
+        check(same_values(costs, {{0, 0.5}, {0.75, 1}}), "negative values are shifted up, and all divided by the max");
+        auto similarities = matrix({{1, 2}, {3, 4}});
+        Util::normalize(similarities, true);
+        check(same_values(similarities, {{0.75, 0.5}, {0.25, 0}}), "normalized similarities are converted to costs in the same pass");
+
+        auto unit = matrix({{0.25, 1}});
+        Util::one_minus(unit);
+        check(same_values(unit, {{0.75, 0}}), "one_minus replaces each value by 1 - value");
+        check(throws<std::runtime_error>([]() { auto over = matrix({{0.5, 1.5}}); Util::one_minus(over); }), "one_minus rejects values outside of [0, 1]");
+
+        // Normalizing, converting and blending in one pass is the same as doing each in turn
+        auto top = matrix({{0.2, 0.4}, {0.6, 0.8}});
+        auto bio = matrix({{1, 2}, {3, 4}});
+        auto normalized = matrix({{1, 2}, {3, 4}});
+        Util::normalize(normalized, true);
+        auto blended = Util::blend(top, normalized, 0.25, "");
+        Util::combine(top, bio, 0.25, true, true);
+        check(same_values(bio, {{0.25 * 0.2 + 0.75 * 0.75, 0.25 * 0.4 + 0.75 * 0.5}, {0.25 * 0.6 + 0.75 * 0.25, 0.25 * 0.8}}),
+              "combine blends the normalized, converted biological costs with the topological ones");
+        check(same_values(blended, {{bio[0][0], bio[0][1]}, {bio[1][0], bio[1][1]}}), "blend gives the same costs as combine, leaving its inputs as they were");
+
+        auto absent = CostMatrix();
+        Util::combine(top, absent, 0.25, true, true);
+        check(same_values(absent, {{0.2, 0.4}, {0.6, 0.8}}), "without biological costs the topological costs are used alone");
+        check(throws<std::runtime_error>([&]() { auto wide = matrix({{1, 2, 3}}); Util::combine(top, wide, 0.5, true, false); }),
+              "matrices of different shapes are not combined");
+        check(throws<std::runtime_error>([&]() { auto over = matrix({{0.5, 1}, {1, 2}}); Util::combine(top, over, 0.5, false, false); }),
+              "a combined cost outside of [0, 1] is rejected");
+    }
+
+    /*
+     * Write the given text to a file in the scratch directory, returning its path.
+     */
+    std::string write_file(std::string name, std::string text)
+    {
+        auto filepath = scratch + name;
+        std::ofstream fout(filepath, std::ios::binary);
+        fout << text;
+        return filepath;
+    }
+
+    bool same_graph(const Graph &a, const Graph &b)
+    {
+        return a.labels == b.labels && a.offsets == b.offsets && a.neighbors == b.neighbors && a.weights == b.weights;
+    }
+
+    /*
+     * The neighbors of node i of the graph.
+     */
+    std::vector<unsigned> row(const Graph &graph, std::size_t i)
+    {
+        return std::vector<unsigned>(graph.neighbors.begin() + graph.offsets[i], graph.neighbors.begin() + graph.offsets[i + 1]);
+    }
+
+    void test_csv_loader()
+    {
+        auto graph = FileIO::file_to_graph(write_file("g.csv", ";a;b;c\r\na;0;2.5;0\r\nb;2.5;0;1e0\r\nc;0;1;0\r\n"), true);
+        check(graph.labels == std::vector<std::string>{"a", "b", "c"}, "labels are read from the first column");
+        check(row(graph, 0) == std::vector<unsigned>{1} && row(graph, 1) == std::vector<unsigned>{0, 2} && row(graph, 2) == std::vector<unsigned>{1},
+              "the neighbors of a node are the nonzero entries of its row, whatever the delimiter and line ending");
+        check(graph.weights == std::vector<double>{2.5, 2.5, 1, 1}, "weights are kept when asked for");
+        check(FileIO::file_to_graph(scratch + "g.csv", false).weights.empty(), "weights are dropped otherwise");
+        check(throws<std::runtime_error>([&]() { FileIO::file_to_graph(write_file("empty.csv", ""), false); }), "an empty file is rejected");
+
+        // The parallel parse of a larger network agrees with reading it line by line
+        auto example = FileIO::file_to_graph(EXAMPLES + "g.csv", false);
+        std::ifstream fin(EXAMPLES + "g.csv");
+        std::string line;
+        std::getline(fin, line);
+        auto is_same = true;
+        std::size_t i = 0;
+        for (; std::getline(fin, line); ++i)
+        {
+            std::vector<unsigned> neighbors;
+            std::stringstream cells(line);
+            std::string cell;
+            std::getline(cells, cell, ',');
+            for (unsigned j = 0; std::getline(cells, cell, ','); ++j)
+            {
+                if (std::stod(cell) != 0)
+                {
+                    neighbors.push_back(j);
+                }
+            }
+            is_same &= (i < example.size() && row(example, i) == neighbors);
+        }
+        check(is_same && i == example.size(), "every row of the example network is parsed as written");
+
+        FileIO::graph_to_file(scratch + "round.csv", example);
+        check(same_graph(FileIO::file_to_graph(scratch + "round.csv", false), example), "a dense CSV loads as the graph it was written from");
+    }
+
+    void test_sparse_formats()
+    {
+        auto text = "# comment\na b 2\nb c\nc d 0\nd a\n";
+        auto graph = FileIO::file_to_graph(write_file("g.edges", text), true);
+        check(graph.labels == std::vector<std::string>{"a", "b", "c", "d"}, "edge list nodes are labelled in order of appearance");
+        check(row(graph, 0) == std::vector<unsigned>{1, 3}, "edge list edges are undirected");
+        check(row(graph, 2) == std::vector<unsigned>{1}, "edge list edges of weight 0 are dropped");
+        check(graph.weights.size() == graph.neighbors.size() && graph.weights[0] == 2, "edge list weights are kept");
+
+        auto labelled = FileIO::file_to_graph(write_file("g.csv", "a,b,2\nb,c,1\nc,d,0\nd,a,1\n"), true);
+        check(same_graph(labelled, graph), "a labelled CSV edge list is detected by its content");
+        check(throws<std::runtime_error>([&]() { FileIO::file_to_graph(write_file("amb.tsv", "x\ty\ny\tx\n"), false); }),
+              "a file that could be either an edge list or a matrix is rejected");
+        auto matrix = FileIO::file_to_graph(write_file("two.csv", "\"\",x,y\nx,0,1\ny,1,0\n"), false);
+        check(matrix.size() == 2 && row(matrix, 0) == std::vector<unsigned>{1}, "a matrix of 2 nodes with an empty corner is still a matrix");
+
+        auto symmetric = FileIO::file_to_graph(write_file("s.mtx", "%%MatrixMarket matrix coordinate real symmetric\n% comment\n3 3 2\n2 1 0.5\n3 3 1\n"), true);
+        check(symmetric.size() == 3 && row(symmetric, 0) == std::vector<unsigned>{1} && row(symmetric, 1) == std::vector<unsigned>{0},
+              "a symmetric Matrix Market entry is an edge both ways");
+        check(Util::degrees(symmetric) == std::vector<unsigned>{1, 1, 0}, "a self-loop is not counted in a degree");
+        auto general = FileIO::file_to_graph(write_file("g.mtx", "%%MatrixMarket matrix coordinate pattern general\n3 3 2\n2 1\n1 3\n"), false);
+        check(row(general, 0) == std::vector<unsigned>{2} && row(general, 1) == std::vector<unsigned>{0}, "a general Matrix Market file is read entry for entry");
+        check(Util::degrees(general) == std::vector<unsigned>{1, 0, 1}, "only the upper triangle of a general Matrix Market file forms edges");
+        check(throws<std::runtime_error>([&]() { FileIO::file_to_graph(write_file("empty.mtx", ""), false); }), "an empty Matrix Market file is a parse error");
+        check(throws<std::runtime_error>([&]() { FileIO::file_to_graph(write_file("h.mtx", "%%MatrixMarket matrix coordinate real hermitian\n1 1 0\n"), false); }),
+              "an unsupported symmetry is rejected");
+
+        for (auto keep_weights : {false, true})
+        {
+            auto example = FileIO::file_to_graph(EXAMPLES + "g.csv", keep_weights);
+            FileIO::graph_to_binary_file(scratch + "g.csr", example);
+            check(same_graph(FileIO::file_to_graph(scratch + "g.csr", keep_weights), example), "a binary CSR file loads as the graph it was written from");
+        }
+        auto from_csr = align("csr", {"-a=0.6"}, scratch + "g.csr");
+        auto from_csv = align("csv", {"-a=0.6"});
+        check(from_csr.match == from_csv.match && from_csr.similarity == from_csv.similarity, "a CSR network aligns as its dense source");
+    }
+
+    void test_npy_outputs()
+    {
+        CostMatrix costs(3, 5);
+        for (std::size_t i = 0; i < costs.rows(); ++i)
+        {
+            for (std::size_t j = 0; j < costs.cols(); ++j)
+            {
+                costs[i][j] = (i * costs.cols() + j) / 15.0;
+            }
+        }
+        costs[1][2] = std::nan("");
+        FileIO::matrix_to_npy_file(scratch + "m.npy", costs);
+        auto loaded = FileIO::npy_file_to_matrix(scratch + "m.npy", "");
+        auto is_same = loaded.rows() == costs.rows() && loaded.cols() == costs.cols();
+        for (std::size_t i = 0; is_same && i < costs.rows(); ++i)
+        {
+            for (std::size_t j = 0; j < costs.cols(); ++j)
+            {
+                is_same &= (loaded[i][j] == costs[i][j]) || (std::isnan(loaded[i][j]) && std::isnan(costs[i][j]));
+            }
+        }
+        check(is_same, "a .npy cost matrix loads exactly as the matrix it was written from, pruned pairs included");
+        check(read_file(scratch + "m.npy").compare(0, 6, "\x93NUMPY") == 0, "a .npy file starts with the NumPy magic string");
+
+        auto gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(EXAMPLES + "g.csv", false));
+        FileIO::gdvs_to_npy_file(scratch + "gdvs.npy", gdvs);
+        check(FileIO::npy_file_to_gdvs(scratch + "gdvs.npy") == gdvs, "a .npy GDV file loads as the GDVs it was written from");
+
+        // -npy writes the same costs as the CSV outputs, with the labels beside them
+        align("csv", {"-a=0.6"});
+        align("npy", {"-a=0.6", "-npy"});
+        auto directory = scratch + "alignments/npy-h/";
+        check(std::filesystem::exists(directory + "topological_costs.npy") && !std::filesystem::exists(directory + "topological_costs.csv"),
+              "-npy writes the cost matrices as .npy instead of CSV");
+        check(FileIO::npy_file_to_gdvs(directory + "npy_gdvs.npy") == gdvs, "-npy writes the GDVs as .npy");
+        auto g = FileIO::file_to_graph(EXAMPLES + "g.csv", false);
+        auto h = FileIO::file_to_graph(EXAMPLES + "h.csv", false);
+        std::string labels;
+        for (const auto &label : g.labels)
+        {
+            labels += label + "\n";
+        }
+        check(read_file(directory + "npy_labels.txt") == labels, "-npy writes the labels of the rows, one per line");
+        auto from_csv = FileIO::file_to_cost_matrix(scratch + "alignments/csv-h/topological_costs.csv", "", g.labels, h.labels, false);
+        auto from_npy = FileIO::npy_file_to_matrix(directory + "topological_costs.npy", "");
+        auto is_close = from_csv.rows() == from_npy.rows() && from_csv.cols() == from_npy.cols();
+        for (std::size_t i = 0; is_close && i < from_csv.rows(); ++i)
+        {
+            for (std::size_t j = 0; j < from_csv.cols(); ++j)
+            {
+                is_close &= std::abs(from_csv[i][j] - from_npy[i][j]) < 1e-6;
+            }
+        }
+        check(is_close, "the .npy costs are the CSV costs");
+    }
+
+    void test_logger()
+    {
+        // Capture the console, to see what is echoed
+        std::stringstream console;
+        auto *cout = std::cout.rdbuf(console.rdbuf());
+        auto *cerr = std::cerr.rdbuf(console.rdbuf());
+        auto filepath = scratch + "log.txt";
+        {
+            Logger log;
+            log.out("before open\n");
+            log.out("debug\n", Logger::DEBUG);
+            log.open(filepath);
+            check(read_file(filepath) == "before open\n", "messages logged before the file is opened are written when it is");
+
+            log.out("half ");
+            check(read_file(filepath) == "before open\n", "a partial line is held until the line ends");
+            log.out("a line\n");
+            check(read_file(filepath) == "before open\nhalf a line\n", "a finished line is written at once");
+
+            log.set_level(Logger::DEBUG);
+            log.out("details\n", Logger::DEBUG);
+            log.set_quiet(true);
+            log.out("quiet\n");
+            log.err("failure");
+            log.out("unfinished");
+        }
+        std::cout.rdbuf(cout);
+        std::cerr.rdbuf(cerr);
+
+        auto text = read_file(filepath);
+        check(text.find("debug") == std::string::npos && text.find("details\n") != std::string::npos, "debug messages are only logged at the debug level");
+        check(text.find("quiet\n") != std::string::npos && console.str().find("quiet") == std::string::npos, "a quiet log is written but not echoed");
+        check(text.find("ERROR:\n failure") != std::string::npos && console.str().find("failure") != std::string::npos, "errors are echoed even when quiet");
+        check(text.size() >= 10 && text.compare(text.size() - 10, 10, "unfinished") == 0, "the log is flushed when it is destroyed");
+
+        check(throws<std::runtime_error>([&]() { Logger log; log.open(scratch); }), "a log that cannot be opened is reported");
+    }
+
+    void test_async_writer()
+    {
+        std::vector<int> order;
+        auto caller = std::this_thread::get_id();
+        auto is_elsewhere = true;
+        {
+            AsyncWriter writer;
+            for (int n = 0; n < 10; ++n)
+            {
+                writer.submit([&, n]() { order.push_back(n); is_elsewhere &= std::this_thread::get_id() != caller; });
+            }
+            writer.wait();
+            check(order == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, "jobs run one at a time, in the order submitted");
+            check(is_elsewhere, "jobs run on the writer's own thread");
+
+            writer.submit([&]() { order.push_back(10); });
+        }
+        check(order.size() == 11, "the writer finishes its queued jobs when destroyed");
+
+        // A full queue holds back the submitter until a job finishes
+        std::promise<void> release;
+        auto released = release.get_future().share();
+        std::atomic<bool> is_submitted = false;
+        {
+            AsyncWriter writer(1);
+            writer.submit([released]() { released.wait(); }); // running
+            writer.submit([]() {});                           // queued
+            std::thread submitter([&]() { writer.submit([]() {}); is_submitted = true; });
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            check(!is_submitted, "submitting to a full queue waits");
+            release.set_value();
+            submitter.join();
+            writer.wait();
+            check(is_submitted, "a waiting submission is queued once there is room");
+        }
+
+        // The first error is raised, and nothing runs after it
+        AsyncWriter writer;
+        auto is_run = false;
+        writer.submit([]() { throw std::runtime_error("first"); });
+        writer.submit([]() { throw std::runtime_error("second"); });
+        std::string error;
+        try
+        {
+            writer.wait();
+        }
+        catch (std::runtime_error &e)
+        {
+            error = e.what();
+        }
+        check(error == "first", "waiting raises the first job's error");
+        check(throws<std::runtime_error>([&]() { writer.submit([&]() { is_run = true; }); }), "submitting after a failure raises the error");
+        check(!is_run, "no job runs after a failure");
+
+        // Jobs count their work in the metrics of the thread that made the writer
+        Metrics metrics;
+        {
+            Metrics::Scope scope(&metrics);
+            AsyncWriter counted;
+            counted.submit([]() { Metrics::add(Metrics::BYTES_WRITTEN, 42); });
+            counted.wait();
+        }
+        check(metrics.to_json().find("\"bytes_written\": 42") != std::string::npos, "jobs count their work for the thread that made the writer");
+    }
+
+    /*
+     * The least total cost of assigning every row of a square matrix to a distinct column, by brute force.
+     */
+    double optimum(const CostMatrix &costs)
+    {
+        std::vector<std::size_t> columns(costs.cols());
+        std::iota(columns.begin(), columns.end(), 0);
+        auto best = std::numeric_limits<double>::max();
+        do
+        {
+            double total = 0;
+            for (std::size_t i = 0; i < costs.rows(); ++i)
+            {
+                total += costs[i][columns[i]];
+            }
+            best = std::min(best, total);
+        } while (std::next_permutation(columns.begin(), columns.end()));
+        return best;
+    }
+
+    void test_sparse_assignment()
+    {
+        // The solver finds an optimal assignment, and reports each pair's similarity
+        unsigned state = 7;
+        auto is_optimal = true;
+        auto is_consistent = true;
+        for (unsigned trial = 0; trial < 20; ++trial)
+        {
+            CostMatrix costs(6, 6);
+            for (std::size_t i = 0; i < costs.rows(); ++i)
+            {
+                for (std::size_t j = 0; j < costs.cols(); ++j)
+                {
+                    state = state * 1103515245 + 12345;
+                    costs[i][j] = (state >> 16) % 100 / 100.0;
+                }
+            }
+            auto alignment = Hungarian::hungarian(costs, "", false);
+            double total = 0;
+            for (std::size_t i = 0; i < costs.rows(); ++i)
+            {
+                total += costs[i][alignment.match[i]];
+                is_consistent &= std::abs(alignment.similarity[i] - (1 - costs[i][alignment.match[i]])) < EPSILON;
+            }
+            is_optimal &= std::abs(total - optimum(costs)) < 1e-9;
+        }
+        check(is_optimal, "the solver finds an assignment of least total cost");
+        check(is_consistent, "each pair's similarity is 1 - its cost");
+
+        auto tall = Hungarian::hungarian(matrix({{0.9, 0.1}, {0.2, 0.8}, {0.5, 0.5}}), "", false);
+        check(tall.rows == 3 && tall.cols == 2 && tall.match == std::vector<std::size_t>{1, 0, Assignment::NONE},
+              "a node of G left over when G is larger than H is aligned to nothing");
+        auto wide = Hungarian::hungarian(matrix({{0.9, 0.1, 0.5}}), "", false);
+        check(wide.match == std::vector<std::size_t>{1}, "a larger H leaves nodes of H unaligned");
+        check(std::abs(Util::net_cost(tall, 0.85) - 0.1) < EPSILON, "the net cost counts the pairs above the threshold");
+
+        // The dense matrix output holds exactly the pairs of the list output
+        FileIO::alignment_to_matrix_file(scratch + "matrix.csv", {"a", "b", "c"}, {"x", "y"}, tall, 0);
+        FileIO::alignment_to_list_file(scratch + "list.csv", {"a", "b", "c"}, {"x", "y"}, tall, 0);
+        check(read_file(scratch + "matrix.csv") == "\"\",x,y\na,0,0.9\nb,0.8,0\nc,0,0", "the alignment matrix is written from the assignment");
+        check(read_file(scratch + "list.csv") == "0.3,,\na,y,0.9\nb,x,0.8\n", "the alignment list is written from the assignment");
+    }
+
+    /*
+     * The text of a gzip-compressed file.
+     */
+    std::string read_gzip(std::string filepath)
+    {
+        std::string text;
+        gzFile gz = gzopen(filepath.c_str(), "rb");
+        if (gz == nullptr)
+        {
+            return text;
+        }
+        char chunk[4096];
+        int n;
+        while ((n = gzread(gz, chunk, sizeof(chunk))) > 0)
+        {
+            text.append(chunk, n);
+        }
+        gzclose(gz);
+        return text;
+    }
+
+    /*
+     * Compress the given file into a .gz file of the given name in the scratch directory, returning its path.
+     */
+    std::string write_gzip(std::string filepath, std::string name)
+    {
+        auto text = read_file(filepath);
+        auto gz_filepath = scratch + name;
+        gzFile gz = gzopen(gz_filepath.c_str(), "wb");
+        gzwrite(gz, text.data(), text.size());
+        gzclose(gz);
+        return gz_filepath;
+    }
+
+    void test_gzip()
+    {
+        align("plain", {"-a=0.6", "-B=" + EXAMPLES + "bio.csv", "-b=0.5", "-s"});
+        align("gz", {"-a=0.6", "-B=" + EXAMPLES + "bio.csv", "-b=0.5", "-s", "-z"});
+        auto plain = scratch + "alignments/plain-h/";
+        auto gz = scratch + "alignments/gz-h/";
+        check(read_file(gz + "overall_costs.csv.gz").compare(0, 2, "\x1f\x8b") == 0, "-z writes gzip files");
+        check(!std::filesystem::exists(gz + "overall_costs.csv"), "-z writes no uncompressed copies");
+        for (auto name : {"alignment_list.csv", "topological_costs.csv", "overall_costs.csv", "gz_gdvs.csv"})
+        {
+            auto plain_name = (std::string(name) == "gz_gdvs.csv") ? "plain_gdvs.csv" : name;
+            check(read_gzip(gz + name + ".gz") == read_file(plain + plain_name), std::string("-z compresses ") + name + " without changing it");
+        }
+
+        // Compressed inputs are decompressed into a temporary file that is gone once they are read
+        auto tmp = scratch + "tmp/";
+        std::filesystem::create_directories(tmp);
+        auto *previous = std::getenv("TMPDIR");
+        std::string previous_tmpdir = (previous == nullptr) ? "" : previous;
+        setenv("TMPDIR", tmp.c_str(), 1);
+        auto g_gz = write_gzip(EXAMPLES + "g.csv", "g.csv.gz");
+        auto bio_gz = write_gzip(EXAMPLES + "bio.csv", "bio.csv.gz");
+        auto from_gz = FileIO::file_to_graph(g_gz, true);
+        check(same_graph(from_gz, FileIO::file_to_graph(EXAMPLES + "g.csv", true)), "a .gz network loads as its uncompressed file");
+        check(std::filesystem::is_empty(tmp), "the decompressed text of an input leaves no temporary file");
+        auto aligned = align("gz_inputs", {"-a=0.6", "-B=" + bio_gz, "-b=0.5", "-s"}, g_gz);
+        auto reference = align("plain_inputs", {"-a=0.6", "-B=" + EXAMPLES + "bio.csv", "-b=0.5", "-s"});
+        check(aligned.match == reference.match && aligned.similarity == reference.similarity, "compressed inputs align as their uncompressed files");
+        if (previous == nullptr)
+        {
+            unsetenv("TMPDIR");
+        }
+        else
+        {
+            setenv("TMPDIR", previous_tmpdir.c_str(), 1);
+        }
+
+        check(FileIO::input_size(bio_gz) == std::filesystem::file_size(EXAMPLES + "bio.csv"), "the size of a compressed input is its uncompressed size");
+        check(FileIO::input_size(EXAMPLES + "bio.csv") == std::filesystem::file_size(EXAMPLES + "bio.csv"), "the size of an uncompressed input is its file size");
+    }
+
+    void test_biological_labels()
+    {
+        const std::vector<std::string> G = {"a", "b"}, H = {"x", "y"};
+
+        // A reordered superset is matched by label
+        auto superset = write_file("superset.csv", "\"\",z,y,x\nc,9,9,9\nb,9,4,3\na,9,2,1\n");
+        check(same_values(FileIO::file_to_cost_matrix(superset, "", G, H, false), {{1, 2}, {3, 4}}), "rows and columns are matched to nodes by label");
+
+        // Labels unrelated to the networks are read in the networks' order
+        auto unlabelled = write_file("unlabelled.csv", ",1,2\n1,1,2\n2,3,4\n");
+        check(same_values(FileIO::file_to_cost_matrix(unlabelled, "", G, H, false), {{1, 2}, {3, 4}}), "a matrix labelled with none of the nodes is read by position");
+
+        // A typo in one label of a reordered matrix is an error, rather than a reason to read it by position
+        auto typo = write_file("typo.csv", ",y,x\nb,4,3\nA,2,1\n");
+        std::string error;
+        try
+        {
+            FileIO::file_to_cost_matrix(typo, "", G, H, false);
+        }
+        catch (std::runtime_error &e)
+        {
+            error = e.what();
+        }
+        check(error.find("node a") != std::string::npos, "a matrix with only some labels matching is rejected, naming the missing node");
+        check(throws<std::runtime_error>([&]() { FileIO::file_to_cost_matrix(write_file("short.csv", ",x,y\na,1,2\n"), "", G, H, false); }),
+              "a matrix without a row for every node is rejected");
+
+        // Triplets
+        auto triplets = write_file("bio.triplets", "g,h,value\n# comment\na,x,0.5\nb,y,0.25\na,x,0.75\nc,x,9\n");
+        check(same_values(FileIO::file_to_cost_matrix(triplets, "", G, H, false), {{0.75, 0.75}, {0.75, 0.25}}),
+              "a triplet sets its pair, later triplets win, and missing pairs get the maximal cost");
+        check(same_values(FileIO::file_to_cost_matrix(triplets, "", G, H, true), {{0.75, 0.25}, {0.25, 0.25}}),
+              "missing pairs of similarities get the minimal similarity");
+        check(throws<std::runtime_error>([&]() { FileIO::file_to_cost_matrix(write_file("bad.triplets", "a,x,1\na,y\n"), "", G, H, false); }),
+              "a line that is not a triplet is rejected");
+        check(throws<std::runtime_error>([&]() { FileIO::file_to_cost_matrix(write_file("none.triplets", "c,z,1\n"), "", G, H, false); }),
+              "triplets for none of the nodes are rejected");
+    }
+
+    void test_streamed_combine()
+    {
+        auto g = FileIO::file_to_graph(EXAMPLES + "g.csv", false);
+        auto h = FileIO::file_to_graph(EXAMPLES + "h.csv", false);
+        auto g_gdvs = GraphCrunch::graphcrunch(g);
+        auto h_gdvs = GraphCrunch::graphcrunch(h);
+
+        // The example matrix, and the same entries as triplets in reverse order
+        auto example = FileIO::file_to_cost_matrix(EXAMPLES + "bio.csv", "", g.labels, h.labels, false);
+        std::string triplets;
+        for (auto i = g.size(); i-- > 0;)
+        {
+            for (auto j = h.size(); j-- > 0;)
+            {
+                triplets += g.labels[i] + "," + h.labels[j] + "," + Util::to_string(example[i][j], 17) + "\n";
+            }
+        }
+        for (auto bio_file : {EXAMPLES + "bio.csv", write_file("bio.triplets", triplets)})
+        {
+            auto in_memory = GDVs_Dist::gdvs_dist(g_gdvs, h_gdvs, 1, 1, "");
+            auto bio = FileIO::file_to_cost_matrix(bio_file, "", g.labels, h.labels, true);
+            Util::combine(in_memory, bio, 0.5, true, true);
+            auto streamed = GDVs_Dist::gdvs_dist(g_gdvs, h_gdvs, 1, 1, scratch);
+            Util::combine_streamed(streamed, bio_file, scratch, g.labels, h.labels, 0.5, true);
+
+            auto is_same = streamed.rows() == bio.rows() && streamed.cols() == bio.cols();
+            for (std::size_t i = 0; is_same && i < bio.rows(); ++i)
+            {
+                for (std::size_t j = 0; j < bio.cols(); ++j)
+                {
+                    is_same &= std::abs(streamed[i][j] - bio[i][j]) < EPSILON;
+                }
+            }
+            check(is_same, "streaming " + bio_file + " blends the same costs as loading it whole");
+        }
+
+        // An alignment out of core streams its biological matrix, with the same result
+        auto in_core = align("in_core", {"-B=" + EXAMPLES + "bio.csv", "-b=0.5", "-s"});
+        auto streamed = align("streamed", {"-B=" + EXAMPLES + "bio.csv", "-b=0.5", "-s", "-scratch=" + scratch});
+        check(in_core.match == streamed.match && in_core.similarity == streamed.similarity, "an out-of-core alignment streams the biological matrix to the same result");
+    }
+
+    void test_top_k_candidates()
+    {
+        auto costs = matrix({{0.5, 0.1, 0.5, 0.3}, {std::nan(""), 0.2, 0.9, 0.1}});
+        auto top = Util::top_k(costs, 3);
+        check(top.rows == 2 && top.k == 3, "k candidates are kept per node of G");
+        check(std::vector<std::size_t>(top.match.begin(), top.match.begin() + 3) == std::vector<std::size_t>{1, 3, 0},
+              "candidates are best first, with ties broken by the lower index in H");
+        check(std::vector<std::size_t>(top.match.begin() + 3, top.match.end()) == std::vector<std::size_t>{3, 1, 2} && top.cost[3] == 0.1,
+              "a pruned pair comes after every evaluated one");
+        check(Util::top_k(costs, 10).k == 4, "k is capped at |H|");
+
+        // The selection agrees with sorting each row of the example costs in full
+        auto g_gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(EXAMPLES + "g.csv", false));
+        auto h_gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(EXAMPLES + "h.csv", false));
+        auto example = GDVs_Dist::gdvs_dist(g_gdvs, h_gdvs, 0.6, 1, "");
+        const std::size_t K = 5;
+        auto selected = Util::top_k(example, K);
+        auto is_same = true;
+        for (std::size_t i = 0; i < example.rows(); ++i)
+        {
+            std::vector<std::size_t> order(example.cols());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return example[i][a] < example[i][b]; });
+            is_same &= std::equal(order.begin(), order.begin() + K, selected.match.begin() + i * K);
+        }
+        check(is_same, "the top k of every row are those of a full sort");
+
+        // -k= writes them after a header row, as g_node,h_node,rank,cost
+        align("k", {"-a=0.6", "-k=" + std::to_string(K)});
+        auto text = read_file(scratch + "alignments/k-h/candidates.csv");
+        check(std::count(text.begin(), text.end(), '\n') == std::ptrdiff_t(example.rows() * K + 1), "-k= lists k candidates for each node of G");
+        check(text.find("g_node,h_node,rank,cost\n") == 0, "the candidates have a header row");
+    }
+
+    void test_one_vs_many()
+    {
+        // A directory names its visible files in sorted order
+        std::filesystem::create_directory(scratch + "set");
+        auto h_text = read_file(EXAMPLES + "h.csv");
+        write_file("set/h2.csv", h_text);
+        write_file("set/h1.csv", h_text);
+        write_file("set/.hidden.csv", h_text);
+        check(Pipeline::network_files(scratch + "set") == std::vector<std::string>{scratch + "set/h1.csv", scratch + "set/h2.csv"},
+              "a directory names its visible files, sorted");
+
+        // A list names its files in order, relative to the list, skipping blank lines and comments
+        auto list = write_file("set.list", "# networks\nset/h2.csv\n\n  set/h1.csv  \r\n" + scratch + "set/h2.csv\n");
+        check(Pipeline::network_files(list) == std::vector<std::string>{scratch + "set/h2.csv", scratch + "set/h1.csv", scratch + "set/h2.csv"},
+              "a list names its files in order, relative to the list");
+        check(throws<std::runtime_error>([&]() { Pipeline::network_files(write_file("none.list", "# nothing\n\n")); }), "an empty list is rejected");
+        check(throws<std::runtime_error>([&]() { Pipeline::network_files(scratch + "missing.list"); }), "a missing list is rejected");
+
+        // G is read and counted once, and aligns to each network as on its own
+        auto alone = align("g", {});
+        auto s = settings({EXAMPLES + "g.csv", list});
+        auto g = Pipeline::network(EXAMPLES + "g.csv", "");
+        for (const auto &file : Pipeline::network_files(scratch + "set"))
+        {
+            auto h = Pipeline::network(file, "");
+            Logger log;
+            auto assignment = Pipeline::align(s, g, h, log);
+            check(g.is_loaded && g.is_counted, "G is kept read and counted for the next alignment");
+            check(assignment.match == alone.match, "G aligns to each network of the set as to the network alone");
+            check(read_file(scratch + "alignments/g-" + h.name + "/alignment_list.csv") == read_file(scratch + "alignments/g-h/alignment_list.csv"),
+                  "each alignment writes its own output directory");
+        }
+    }
+
+    void test_all_pairs()
+    {
+        // Parallel work keeps to the thread budget of the thread that started it, as do the stages' threads
+        std::mutex mutex;
+        std::set<std::thread::id> ids;
+        Util::set_thread_budget(2);
+        Util::parallel_for(64, 1, [&](std::size_t, std::size_t)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::lock_guard<std::mutex> lock(mutex);
+            ids.insert(std::this_thread::get_id());
+        });
+        check(ids.size() <= 2, "parallel_for keeps to the thread budget");
+        std::size_t inherited = 0;
+        TaskGraph graph;
+        graph.add([&]() { inherited = Util::thread_budget(); });
+        graph.run(1);
+        check(inherited == 2, "a task has the thread budget of the thread that ran the graph");
+        Util::set_thread_budget(0);
+        check(Util::thread_budget() == std::max(1u, std::thread::hardware_concurrency()), "the budget is every hardware thread by default");
+
+        // Every pair of a set is aligned once, as each pair would be alone
+        std::filesystem::create_directory(scratch + "set");
+        write_file("set/a.csv", read_file(EXAMPLES + "g.csv"));
+        write_file("set/b.csv", read_file(EXAMPLES + "h.csv"));
+        write_file("set/c.csv", read_file(EXAMPLES + "g.csv"));
+        std::vector<Network> set;
+        for (const auto &file : Pipeline::network_files(scratch + "set"))
+        {
+            set.push_back(Pipeline::network(file, ""));
+        }
+        auto s = settings({scratch + "set", scratch + "set"});
+        check(Pipeline::align_all(s, set, set, true) == 0, "every pair aligns");
+        auto summary = Util::split(read_file(scratch + "alignments/summary.csv"), '\n');
+        check(summary.size() >= 4 && summary[0] == "g_network,h_network,net_cost", "the summary has a header row");
+        std::set<std::string> pairs;
+        for (std::size_t i = 1; i < summary.size(); ++i)
+        {
+            if (summary[i] != "")
+            {
+                auto fields = Util::split(summary[i], ',');
+                pairs.insert(fields[0] + "-" + fields[1]);
+            }
+        }
+        check(pairs == std::set<std::string>{"a-b", "a-c", "b-c"}, "the summary has each pair once");
+
+        auto alone = align("g", {});
+        check(read_file(scratch + "alignments/a-b/alignment_list.csv") == read_file(scratch + "alignments/g-h/alignment_list.csv"),
+              "a pair aligns as it would alone");
+        check(std::filesystem::exists(scratch + "alignments/a-c/alignment_list.csv") && std::filesystem::exists(scratch + "alignments/b-c/alignment_list.csv"),
+              "each pair writes its own output directory");
+    }
+
+    void test_sweep()
+    {
+        auto bio = "-B=" + EXAMPLES + "bio.csv";
+        auto s = settings({EXAMPLES + "g.csv", EXAMPLES + "h.csv", bio});
+        auto g = Pipeline::network(EXAMPLES + "g.csv", "");
+        auto h = Pipeline::network(EXAMPLES + "h.csv", "");
+        const std::vector<std::string> alphas = {"0.5", "1"}, betas = {"0", "0.5"};
+        check(Pipeline::sweep(s, g, h, alphas, betas) == 0, "every setting aligns");
+
+        std::string parent;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(scratch + "alignments"))
+        {
+            if (entry.path().filename() == "sweep_summary.csv")
+            {
+                parent = entry.path().parent_path().string() + "/";
+            }
+        }
+        check(parent != "", "the sweep writes a summary to the pair's parent directory");
+        check(read_file(parent + "sweep_summary.csv").find("alpha,beta,net_cost\n0.5,0,") == 0, "the summary lists each setting in the order given");
+
+        // Each setting, in its own directory, aligns as it would alone, although the intermediates are reused
+        for (const auto &alpha : alphas)
+        {
+            for (const auto &beta : betas)
+            {
+                auto alias = "a" + alpha + "-b" + beta;
+                auto alone = align(alias, {bio, "-a=" + alpha, "-b=" + beta});
+                std::string directory;
+                for (const auto &entry : std::filesystem::directory_iterator(parent))
+                {
+                    auto name = entry.path().filename().string();
+                    if (entry.is_directory() && name.size() >= alias.size() && name.compare(name.size() - alias.size(), alias.size(), alias) == 0)
+                    {
+                        directory = entry.path().string() + "/";
+                    }
+                }
+                auto list = read_file(directory + "alignment_list.csv");
+                check(directory != "" && list != "" && list == read_file(scratch + "alignments/" + alias + "-h/alignment_list.csv"),
+                      "alpha = " + alpha + ", beta = " + beta + " aligns as it would alone");
+            }
+        }
+    }
+
+    void test_task_graph()
+    {
+        // Each task starts only after those it comes after, and independent tasks overlap
+        TaskGraph graph;
+        std::mutex mutex;
+        std::vector<std::string> order;
+        auto record = [&](std::string name, int ms)
+        {
+            return [&, name, ms]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(name);
+            };
+        };
+        auto a = graph.add(record("a", 50));
+        auto b = graph.add(record("b", 50));
+        auto c = graph.add(record("c", 0), {a, b});
+        auto d = graph.add(record("d", 0), {c});
+        graph.run(2);
+        check(order.size() == 4 && order[2] == "c" && order[3] == "d", "a task runs after every task it comes after");
+        check(graph.elapsed_ms({a, b}) < 95, "independent tasks run at the same time");
+        check(graph.elapsed_ms({d}) >= 0 && graph.elapsed_ms({}) == 0, "tasks that did not run take no time");
+        check(throws<std::invalid_argument>([&]() { graph.add([]() {}, {d + 1}); }), "a task cannot come after one not yet added");
+
+        // One thread runs the tasks in the order they were added, once each ready
+        TaskGraph serial;
+        order.clear();
+        auto first = serial.add(record("first", 0));
+        serial.add(record("second", 0));
+        serial.add(record("third", 0), {first});
+        serial.run(1);
+        check(order == std::vector<std::string>{"first", "second", "third"}, "ready tasks start in the order they were added");
+
+        // A failure stops the tasks after it, and is rethrown once the running ones finish
+        TaskGraph failing;
+        std::atomic<bool> is_after_run(false), is_beside_run(false);
+        failing.add([&]() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); is_beside_run = true; });
+        auto fails = failing.add([]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            throw std::runtime_error("stage failed");
+        });
+        failing.add([&]() { is_after_run = true; }, {fails});
+        std::string message;
+        try
+        {
+            failing.run(2);
+        }
+        catch (std::runtime_error &e)
+        {
+            message = e.what();
+        }
+        check(message == "stage failed", "the error of the failed task is rethrown");
+        check(!is_after_run, "no task after a failed one runs");
+        check(is_beside_run, "the running tasks finish before the error is rethrown");
+    }
+
+    void test_library()
+    {
+        auto g = FileIO::file_to_graph(EXAMPLES + "g.csv", false);
+        auto h = FileIO::file_to_graph(EXAMPLES + "h.csv", false);
+        MiNAA::GraphView g_view{g.size(), g.offsets.data(), g.neighbors.data()};
+        MiNAA::GraphView h_view{h.size(), h.offsets.data(), h.neighbors.data()};
+
+        // Networks in memory align as the same networks in files
+        MiNAA::Options options;
+        options.alpha = 0.6;
+        options.do_gdvs = true;
+        auto result = MiNAA::align(g_view, h_view, std::nullopt, options);
+        check(result.alignment.match == align("top", {"-a=0.6"}).match, "an alignment in memory matches one of files");
+        check(result.g_gdvs == GraphCrunch::graphcrunch(g) && result.h_gdvs == GraphCrunch::graphcrunch(h), "the GDVs are returned if asked for");
+
+        auto bio = FileIO::file_to_cost_matrix(EXAMPLES + "bio.csv", "", g.labels, h.labels, false);
+        MiNAA::CostView bio_view{bio.rows(), bio.cols(), bio[0], false};
+        options.beta = 0.5;
+        options.do_gdvs = false;
+        result = MiNAA::align(g_view, h_view, bio_view, options);
+        check(result.alignment.match == align("bio", {"-a=0.6", "-b=0.5", "-B=" + EXAMPLES + "bio.csv"}).match,
+              "a biological matrix in memory is combined as one in a file");
+        check(result.g_gdvs.empty() && result.h_gdvs.empty(), "the GDVs are only returned if asked for");
+        options.beta = 0;
+        check(MiNAA::align(g_view, h_view, bio_view, options).alignment.match == align("only_bio", {"-b=0", "-B=" + EXAMPLES + "bio.csv"}).match,
+              "with beta = 0 only the biological matrix is aligned by");
+
+        // Malformed inputs and options are rejected
+        options = MiNAA::Options();
+        auto rejects = [&](MiNAA::GraphView g_bad, std::optional<MiNAA::CostView> bio_bad, MiNAA::Options options_bad)
+        {
+            return throws<std::invalid_argument>([&]() { MiNAA::align(g_bad, h_view, bio_bad, options_bad); });
+        };
+        options.alpha = 1.5;
+        check(rejects(g_view, std::nullopt, options), "alpha out of range is rejected");
+        options = MiNAA::Options();
+        check(rejects(g_view, MiNAA::CostView{bio.rows(), bio.cols() - 1, bio[0], false}, options), "a biological matrix of the wrong shape is rejected");
+        std::vector<std::size_t> offsets = {0, 1, 0};
+        std::vector<unsigned> neighbors = {1};
+        check(rejects({2, offsets.data(), neighbors.data()}, std::nullopt, options), "decreasing offsets are rejected");
+        offsets = {0, 1, 1};
+        neighbors = {2};
+        check(rejects({2, offsets.data(), neighbors.data()}, std::nullopt, options), "a neighbor outside the network is rejected");
+        check(rejects({2, nullptr, nullptr}, std::nullopt, options), "a network without offsets is rejected");
+    }
+
+    /*
+     * The value of a counter of the given metrics.
+     */
+    unsigned long long counter(const Metrics &metrics, std::string name)
+    {
+        auto json = metrics.to_json();
+        auto at = json.find("\"" + name + "\": ");
+        return at == std::string::npos ? 0 : std::stoull(json.substr(at + name.size() + 4));
+    }
+
+    void test_network_cache()
+    {
+        auto g_file = write_file("g.csv", read_file(EXAMPLES + "g.csv"));
+        auto h_file = write_file("h.csv", read_file(EXAMPLES + "h.csv"));
+        auto g_gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(g_file, false));
+        auto h_gdvs = GraphCrunch::graphcrunch(FileIO::file_to_graph(h_file, false));
+        NetworkCache cache(1);
+        Metrics metrics;
+        Metrics::Scope scope(&metrics);
+
+        // A network is read and counted once, and named as asked each time
+        auto g = cache.get(g_file, "", true);
+        auto read = counter(metrics, "bytes_read");
+        auto graphlets = counter(metrics, "graphlets");
+        check(g.is_loaded && g.is_counted && g.gdvs == g_gdvs, "a network is read and counted");
+        auto again = cache.get(g_file, "other", true);
+        check(counter(metrics, "bytes_read") == read && counter(metrics, "graphlets") == graphlets, "a cached network is not processed again");
+        check(again.name == "other" && g.name == "g" && same_graph(again.graph, g.graph), "a cached network takes the alias of each request");
+        auto uncounted = cache.get(h_file, "", false);
+        check(uncounted.is_loaded && !uncounted.is_counted, "a network is only counted if asked");
+
+        // With a capacity of one, reading H dropped G, which is then read again
+        read = counter(metrics, "bytes_read");
+        cache.get(g_file, "", false);
+        check(counter(metrics, "bytes_read") > read, "the least recently used network is dropped");
+
+        // A changed file is read again
+        read = counter(metrics, "bytes_read");
+        std::filesystem::last_write_time(g_file, std::filesystem::last_write_time(g_file) + std::chrono::seconds(1));
+        cache.get(g_file, "", false);
+        check(counter(metrics, "bytes_read") > read, "a network whose file has changed is read again");
+
+        // Requests for the same network at once share one reading of it
+        NetworkCache shared(4);
+        std::vector<std::future<Network>> requests;
+        read = counter(metrics, "bytes_read");
+        for (int i = 0; i < 4; ++i)
+        {
+            requests.push_back(std::async(std::launch::async, [&]() { Metrics::Scope inner(&metrics); return shared.get(h_file, "", true); }));
+        }
+        auto is_same = true;
+        for (auto &request : requests)
+        {
+            is_same &= request.get().gdvs == h_gdvs;
+        }
+        check(is_same, "concurrent requests get the same network");
+        check(counter(metrics, "bytes_read") - read <= std::filesystem::file_size(h_file), "a network requested at once is read by one request");
+    }
+
+    #ifndef _WIN32
+    /*
+     * Send a request to the server listening on the given socket, returning its reply.
+     */
+    std::string request(std::string socket_path, std::string line)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        socket_path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            close(fd);
+            return "";
+        }
+        line += "\n";
+        if (send(fd, line.data(), line.size(), MSG_NOSIGNAL) < 0)
+        {
+            close(fd);
+            return "";
+        }
+        std::string reply;
+        char buffer[256];
+        for (auto n = read(fd, buffer, sizeof(buffer)); n > 0; n = read(fd, buffer, sizeof(buffer)))
+        {
+            reply.append(buffer, n);
+        }
+        close(fd);
+        return reply;
+    }
+    #endif
+
+    void test_server()
+    {
+        #ifndef _WIN32
+        // The server writes to alignments/ in its working directory, so it runs in the scratch directory
+        auto examples = std::filesystem::absolute(EXAMPLES).string();
+        align("cli", {"-a=0.6"});
+        auto root = std::filesystem::current_path();
+        std::filesystem::current_path(scratch);
+        auto socket_path = scratch + "minaa.sock";
+        std::thread([socket_path]()
+        {
+            try
+            {
+                Server::serve(socket_path, 4);
+            }
+            catch (std::exception &e)
+            {
+                std::cerr << "  server: " << e.what() << std::endl;
+            }
+        }).detach();
+        for (int i = 0; i < 500 && request(socket_path, "") == ""; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        // Requests for the same pair at once each align it, one after the other, into the same folder
+        auto line = examples + "g.csv " + examples + "h.csv -a=0.6";
+        std::vector<std::future<std::string>> replies;
+        for (int i = 0; i < 4; ++i)
+        {
+            replies.push_back(std::async(std::launch::async, [&]() { return request(socket_path, line); }));
+        }
+        std::set<std::string> distinct;
+        for (auto &reply : replies)
+        {
+            distinct.insert(reply.get());
+        }
+        check(distinct.size() == 1 && distinct.begin()->find("OK ") == 0, "concurrent requests for the same pair all succeed alike");
+        auto list = read_file("alignments/g-h/alignment_list.csv");
+        check(list != "" && list == read_file(scratch + "alignments/cli-h/alignment_list.csv"),
+              "the pair's folder holds the alignment, as from the command line");
+
+        check(request(socket_path, examples + "g.csv " + examples + "h.csv -a=2").find("ERROR ") == 0, "a request out of range is refused");
+        check(request(socket_path, examples + " " + examples + "h.csv").find("ERROR ") == 0, "a request for a set of networks is refused");
+        check(request(socket_path, "").find("ERROR ") == 0, "an empty request is refused");
+        check(throws<std::runtime_error>([&]() { Server::serve(socket_path, 4); }), "a socket already served on is not taken over");
+        std::filesystem::current_path(root);
+        #endif
+    }
+
+    void test_metrics()
+    {
+        // Counters go to the metrics current on the thread, and nowhere without any
+        Metrics outer, inner;
+        Metrics::add(Metrics::AUGMENTATIONS, 5);
+        {
+            Metrics::Scope outer_scope(&outer);
+            Metrics::add(Metrics::AUGMENTATIONS, 1);
+            {
+                Metrics::Scope inner_scope(&inner);
+                Metrics::add(Metrics::AUGMENTATIONS, 2);
+            }
+            Metrics::add(Metrics::AUGMENTATIONS, 3);
+            check(Metrics::current() == &outer, "a scope restores the metrics current before it");
+        }
+        check(Metrics::current() == nullptr, "no metrics are current outside every scope");
+        check(counter(outer, "augmentations") == 4 && counter(inner, "augmentations") == 2, "work is counted in the current metrics only");
+        {
+            Metrics::Timer timer(outer, "stage");
+            timer.stop();
+        }
+        check(outer.to_json().find("{\"name\": \"stage\", \"ms\": ") != std::string::npos, "a stage is recorded once, when its timer stops");
+        check(outer.to_json().find("\"stage\"", outer.to_json().find("\"stage\"") + 1) == std::string::npos, "a stopped timer is not recorded again");
+
+        // An alignment writes its stages, in order, and counts its work
+        auto g = FileIO::file_to_graph(EXAMPLES + "g.csv", false);
+        auto h = FileIO::file_to_graph(EXAMPLES + "h.csv", false);
+        std::size_t pairs = g.size() * h.size();
+        align("bio", {"-B=" + EXAMPLES + "bio.csv"});
+        auto json = read_file(scratch + "alignments/bio-h/metrics.json");
+        std::vector<std::size_t> at;
+        for (std::string stage : {"read_graphs", "count_gdvs", "topological_costs", "biological_costs", "overall_costs", "alignment"})
+        {
+            at.push_back(json.find("{\"name\": \"" + stage + "\""));
+        }
+        check(std::is_sorted(at.begin(), at.end()) && at.back() != std::string::npos, "metrics.json lists the stages in order");
+        auto value = [&](std::string name) { auto i = json.find("\"" + name + "\": "); return std::stoull(json.substr(i + name.size() + 4)); };
+        check(value("cost_pairs") == pairs && value("pruned_pairs") == 0, "every pair's cost is counted");
+        check(value("graphlets") > 0 && value("augmentations") > 0, "the graphlets and the solver's work are counted");
+        check(value("bytes_read") >= std::filesystem::file_size(EXAMPLES + "bio.csv") && value("bytes_written") > 0, "the bytes read and written are counted");
+
+        align("pruned", {"-st=0.5", "-prune"});
+        json = read_file(scratch + "alignments/pruned-h/metrics.json");
+        check(value("pruned_pairs") > 0 && value("cost_pairs") + value("pruned_pairs") == pairs, "pruned pairs are counted apart from the evaluated ones");
+    }
+
+    void test_generators()
+    {
+        // The same seed gives the same network, and another seed another
+        check(same_graph(Generators::erdos_renyi(60, 0.1, 7), Generators::erdos_renyi(60, 0.1, 7)), "Erdős–Rényi networks are seeded");
+        check(!same_graph(Generators::erdos_renyi(60, 0.1, 7), Generators::erdos_renyi(60, 0.1, 8)), "another seed gives another network");
+        check(same_graph(Generators::barabasi_albert(60, 3, 7), Generators::barabasi_albert(60, 3, 7)), "Barabási–Albert networks are seeded");
+        check(same_graph(Generators::blocks(60, 3, 0.3, 0.02, 7), Generators::blocks(60, 3, 0.3, 0.02, 7)), "block networks are seeded");
+        auto costs = Generators::uniform_costs(5, 7, 7);
+        auto again = Generators::uniform_costs(5, 7, 7);
+        check(std::equal(costs[0], costs[0] + 35, again[0]) && std::all_of(costs[0], costs[0] + 35, [](double c) { return c >= 0 && c < 1; }),
+              "uniform costs are seeded, in [0, 1)");
+
+        // The networks have the structure of their models
+        check(Generators::erdos_renyi(20, 0, 1).neighbors.empty() && Generators::erdos_renyi(20, 1, 1).neighbors.size() == 20 * 19,
+              "an edge probability of 0 or 1 gives no edges or every edge");
+        auto scale_free = Generators::barabasi_albert(60, 3, 1);
+        auto degrees = Util::degrees(scale_free);
+        check(scale_free.neighbors.size() == 2 * 3 * (60 - 3) && *std::min_element(degrees.begin() + 3, degrees.end()) >= 3,
+              "each new node joins m earlier ones");
+        auto split = Generators::blocks(60, 3, 1, 0, 1);
+        auto is_within = true;
+        for (std::size_t i = 0; i < split.size(); ++i)
+        {
+            for (auto j = split.offsets[i]; j < split.offsets[i + 1]; ++j)
+            {
+                is_within &= (i * 3 / 60 == split.neighbors[j] * 3 / 60);
+            }
+        }
+        check(is_within && split.neighbors.size() == 3 * 20 * 19, "with no edges between blocks, each block is complete");
+
+        // A generated network is what reading it back from a file gives
+        auto network = Generators::blocks(30, 2, 0.4, 0.05, 3);
+        FileIO::graph_to_file(scratch + "blocks.csv", network);
+        check(same_graph(FileIO::file_to_graph(scratch + "blocks.csv", false), network), "a generated network is read back as written");
+
+        check(throws<std::invalid_argument>([]() { Generators::erdos_renyi(10, 1.5, 1); }), "an edge probability out of range is rejected");
+        check(throws<std::invalid_argument>([]() { Generators::barabasi_albert(10, 10, 1); }), "m of at least n is rejected");
+        check(throws<std::invalid_argument>([]() { Generators::blocks(10, 0, 0.5, 0.5, 1); }), "no blocks are rejected");
+    }
+
+    void test_memory_plan()
+    {
+        // Networks large enough that their cost matrices are stored out of core through a smaller tile
+        auto g = Pipeline::network(EXAMPLES + "g.csv", "big_g");
+        auto h = Pipeline::network(EXAMPLES + "h.csv", "big_h");
+        g.graph = Generators::erdos_renyi(4000, 0.001, 1);
+        h.graph = Generators::erdos_renyi(4000, 0.001, 2);
+        g.is_loaded = h.is_loaded = true;
+        auto s = settings({EXAMPLES + "g.csv", EXAMPLES + "h.csv"});
+
+        s.mem_limit = std::numeric_limits<std::size_t>::max();
+        auto in_memory = Pipeline::plan(s, g, h, false);
+        check(in_memory.first == "" && in_memory.second > 4000 * 4000 * sizeof(double), "an alignment that fits is planned in memory");
+        s.scratch_dir = scratch;
+        auto given = Pipeline::plan(s, g, h, false);
+        check(given.first == scratch && given.second < in_memory.second, "a given scratch directory is kept, and takes less memory");
+
+        s.scratch_dir = "";
+        s.mem_limit = (given.second + in_memory.second) / 2;
+        auto fallback = Pipeline::plan(s, g, h, false);
+        check(fallback.first == std::filesystem::temp_directory_path().string() && fallback.second <= s.mem_limit,
+              "an alignment that only fits out of core is planned in the temporary directory");
+        s.mem_limit = given.second - 1;
+        check(throws<std::runtime_error>([&]() { Pipeline::plan(s, g, h, false); }), "an alignment that does not fit even out of core is refused");
+
+        // Counting GDVs, and keeping the intermediates, are planned for
+        s.mem_limit = std::numeric_limits<std::size_t>::max();
+        auto kept = Pipeline::plan(s, g, h, true);
+        g.is_counted = h.is_counted = true;
+        auto counted = Pipeline::plan(s, g, h, false);
+        check(kept.second > in_memory.second, "the memory to keep the intermediates is planned");
+        check(counted.second <= in_memory.second, "networks already counted take no memory to count");
+
+        // A gzipped biological file is planned at its uncompressed size
+        auto bio_gz = write_gzip(EXAMPLES + "bio.csv", "bio.csv.gz");
+        check(FileIO::input_size(bio_gz) == std::filesystem::file_size(EXAMPLES + "bio.csv"), "a gzipped input counts at its uncompressed size");
+
+        // From the command line, an alignment over the limit fails before any work, and one within it aligns as without one
+        auto small = Pipeline::network(EXAMPLES + "g.csv", "small");
+        auto small_h = Pipeline::network(EXAMPLES + "h.csv", "");
+        Logger log;
+        check(throws<std::runtime_error>([&]() { Pipeline::align(settings({EXAMPLES + "g.csv", EXAMPLES + "h.csv", "-mem-limit=1K"}), small, small_h, log); }),
+              "-mem-limit= refuses an alignment over it");
+        check(!std::filesystem::exists(scratch + "alignments/small-h/alignment_list.csv"), "an alignment refused by the plan writes no results");
+        check(align("limited", {"-mem-limit=1G"}).match == align("unlimited", {}).match, "an alignment within the limit is unchanged");
+        check(read_file(scratch + "alignments/limited-h/log.txt").find("Planning memory use............................in memory.") != std::string::npos,
+              "the plan is logged");
+    }
+
+    void test_resume()
+    {
+        auto clean = align("clean", {"-a=0.6"});
+
+        // Cut the alignment short once every stage but the last has saved its checkpoint, by putting
+        // a directory where an output file must be written
+        auto directory = scratch + "alignments/resumed-h/";
+        std::filesystem::create_directories(directory + "alignment_matrix.csv");
+        check(throws<std::exception>([&]() { align("resumed", {"-a=0.6", "-checkpoint=1"}); }), "the blocked alignment fails");
+        check(std::filesystem::exists(directory + "checkpoint"), "a failed alignment keeps its checkpoints");
+        std::filesystem::remove(directory + "alignment_matrix.csv");
+
+        auto resumed = align("resumed", {"-a=0.6", "-checkpoint=1", "-resume"});
+        auto log = read_file(directory + "log.txt");
+        check(log.find("Calculating GDVs...............................resumed") != std::string::npos, "the GDVs are resumed");
+        check(log.find("Calculating the topological cost matrix........resumed") != std::string::npos, "the topological costs are resumed");
+        check(resumed.match == clean.match && resumed.similarity == clean.similarity, "a resumed alignment equals an uninterrupted one");
+        check(!std::filesystem::exists(directory + "checkpoint"), "a completed alignment removes its checkpoints");
+        check(read_file(directory + "alignment_list.csv") == read_file(scratch + "alignments/clean-h/alignment_list.csv"),
+              "a resumed alignment writes the same alignment list");
+    }
+
+    void test_solver_resume()
+    {
+        const std::size_t N = 40;
+        CostMatrix costs(N, N);
+        unsigned state = 1;
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            for (std::size_t j = 0; j < N; ++j)
+            {
+                state = state * 1103515245 + 12345;
+                costs[i][j] = (state >> 16) % 1000 / 1000.0;
+            }
+        }
+
+        // With no interval, the solver snapshots its state after every step, and the last one remains
+        Checkpoint checkpoint(scratch + "solver/", "test", 0, false);
+        auto solved = Hungarian::hungarian(costs, "", false, &checkpoint);
+        Checkpoint resumed_checkpoint(scratch + "solver/", "test", 0, true);
+        check(resumed_checkpoint.has("solver.bin"), "the solver leaves a snapshot");
+        auto resumed = Hungarian::hungarian(costs, "", false, &resumed_checkpoint);
+        check(resumed.match == solved.match, "the solver resumed from a snapshot finds the same alignment");
+        check(throws<std::runtime_error>([&]() { Checkpoint(scratch + "solver/", "other", 0, true); }),
+              "checkpoints made with other inputs or parameters are not resumed");
+    }
+}
+
+/*
+ * Run every test, each in a scratch directory of its own, and report the checks that failed.
+ */
+int main()
+{
+    const std::vector<std::pair<std::string, void (*)()>> TESTS = {
+        {"pruning_keeps_exact_costs", test_pruning_keeps_exact_costs},
+        {"pruning_is_opt_in", test_pruning_is_opt_in},
+        {"threshold_keeps_the_alignment", test_threshold_keeps_the_alignment},
+        {"pruning_from_the_command_line", test_pruning_from_the_command_line},
+        {"cost_matrix_store", test_cost_matrix_store},
+        {"fused_matrix_pipeline", test_fused_matrix_pipeline},
+        {"csv_loader", test_csv_loader},
+        {"sparse_formats", test_sparse_formats},
+        {"npy_outputs", test_npy_outputs},
+        {"logger", test_logger},
+        {"async_writer", test_async_writer},
+        {"sparse_assignment", test_sparse_assignment},
+        {"gzip", test_gzip},
+        {"biological_labels", test_biological_labels},
+        {"streamed_combine", test_streamed_combine},
+        {"top_k_candidates", test_top_k_candidates},
+        {"one_vs_many", test_one_vs_many},
+        {"all_pairs", test_all_pairs},
+        {"sweep", test_sweep},
+        {"task_graph", test_task_graph},
+        {"library", test_library},
+        {"network_cache", test_network_cache},
+        {"server", test_server},
+        {"metrics", test_metrics},
+        {"generators", test_generators},
+        {"memory_plan", test_memory_plan},
+        {"resume", test_resume},
+        {"solver_resume", test_solver_resume},
+    };
+
+    auto root = std::filesystem::temp_directory_path() / "minaa_tests";
+    std::filesystem::remove_all(root);
+    for (const auto &[name, test] : TESTS)
+    {
+        std::cout << name << std::endl;
+        scratch = (root / name).string() + "/";
+        std::filesystem::create_directories(scratch);
+        try
+        {
+            test();
+        }
+        catch (std::exception &e)
+        {
+            check(false, std::string("threw ") + e.what());
+        }
+    }
+    std::filesystem::remove_all(root);
+
+    std::cout << (failures == 0 ? "All tests passed." : std::to_string(failures) + " checks failed.") << std::endl;
+    return failures == 0 ? 0 : 1;
+}